@@ -0,0 +1,77 @@
+#pragma once
+
+#include <mpfr.h>
+#include <gmp.h>
+#include <vector>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+#include "Float.hpp"
+
+// Running sum of Floats and doubles, kept exact as sum * 2^scale so result()
+// is correctly rounded whatever the order and number of the terms.
+// The integer grows with the exponent spread of the terms (about 2100 bits
+// for arbitrary doubles) but not with their count, and is capped at
+// precision + WIDTH bits: the bits further below the top are ORed into a
+// sticky bit one position below the last kept one (round to odd), so
+// 1 + 2^-100000 still rounds up under RNDU and ties still break the right
+// way. The result stays correctly rounded while the dropped bits add up to
+// less than one unit of the last kept bit, as they do when a single term
+// or truncation drops them; otherwise it can be off by that unit, which is
+// 2^-WIDTH of the largest partial sum and only shows when the terms cancel
+// down to about that.
+class Accumulator
+{
+public:
+	typedef Float::prec_t prec_t;
+	typedef Float::exp_t exp_t;
+	typedef void builder_pattern;
+
+	static const exp_t WIDTH = 1 << 16;
+
+private:
+	__mpz_struct sum;
+	__mpz_struct term;
+	exp_t scale = 0;
+	prec_t precision;
+	bool nan = false;
+	bool positiveInf = false;
+	bool negativeInf = false;
+	bool nonzero = false;
+	bool positiveZero = false;
+	bool negativeZero = false;
+
+public:
+	Accumulator(prec_t precision);
+	Accumulator(const Accumulator &) = delete;
+	Accumulator &operator=(const Accumulator &) = delete;
+	~Accumulator();
+
+	prec_t getPrecision() const;
+	builder_pattern setPrecision(prec_t precision);
+	builder_pattern reset();
+	builder_pattern add(val v);
+	builder_pattern sub(val v);
+	builder_pattern addAll(val array);
+	builder_pattern addDot(val a, val b);
+	Float result(int rounding);
+	int round(mpfr_ptr out, mpfr_rnd_t rnd) const;
+	// exact sum as m * 2^e (within the WIDTH cap, the last bit then being
+	// sticky), false when it is NaN or infinite
+	bool exact(mpz_ptr m, exp_t &e) const;
+
+	void addFloat(mpfr_srcptr x, bool negate);
+	void addDouble(double x);
+	void addDoubles(const double *x, size_t n);
+	void addProducts(const double *a, const double *b, size_t n);
+
+	// Float64Array contents, read in place when the array is a view on the
+	// wasm memory, otherwise copied once into copy
+	static const double *doubles(val array, std::vector<double> &copy);
+	static bool isFloat64Array(val v);
+
+private:
+	bool special(mpfr_srcptr x, bool negate);
+	void addTerm(mpz_srcptr m, exp_t e);
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <mpfr.h>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+#include "Float.hpp"
+
+// Named Floats and a state string (the loop variables as JSON) kept aside
+// for resuming a long computation. set() copies the value, the computation
+// goes on with its own Float.
+// A checkpoint file is a log of records: a full one holds every entry, a
+// delta only what changed since the previous record. Records carry a
+// generation number and a checksum, load() stops at the first one that is
+// truncated, corrupted or out of sequence, so a crash while appending
+// costs the last delta only.
+// Record: "GMPK" 1, kind (0 full, 1 delta), generation (4 bytes), body
+// length (4 bytes), body, checksum of the header and body (4 bytes).
+// Body: state length, state, entry count, then per entry name length, name,
+// 1 and a Float image, or 0 for a removed entry. Lengths are 4 bytes little
+// endian.
+class Checkpoint
+{
+public:
+	typedef void builder_pattern;
+
+private:
+	std::map<std::string, Float> values;
+	std::set<std::string> changed;
+	std::string state;
+	uint32_t generation = 0;
+	size_t loadedSize = 0;
+
+public:
+	Checkpoint();
+
+	builder_pattern set(const std::string &name, const Float &value);
+	// rounds into out with its rounding, false when the name is not stored
+	bool get(const std::string &name, Float &out) const;
+	bool has(const std::string &name) const;
+	bool remove(const std::string &name);
+	val names() const;
+
+	std::string getState() const;
+	builder_pattern setState(const std::string &state);
+	uint32_t getGeneration() const;
+	// bytes a delta would take, to decide when a full record is worth it
+	size_t getPendingSize() const;
+
+	// next record, a delta unless full; appending it to the file commits it
+	val save(bool full);
+	// applies the records of a checkpoint file, returns how many
+	int load(val bytes);
+	// bytes of the valid records read by the last load, the rest of the file
+	// is a torn or corrupted record to cut off before appending
+	size_t getLoadedSize() const;
+
+	void writeRecord(std::vector<uint8_t> &out, bool full);
+	size_t readRecord(const uint8_t *data, size_t size);
+
+private:
+	void writeEntry(std::vector<uint8_t> &out, const std::string &name) const;
+};
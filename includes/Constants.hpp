@@ -0,0 +1,46 @@
+#pragma once
+
+#include <mpfr.h>
+#include <map>
+#include <string>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+#include "Float.hpp"
+
+// Process wide store of constants rounded to nearest, at the highest
+// precision asked so far. A request at a lower precision is rounded from
+// the stored value when mpfr_can_round proves it correct (ternary
+// included), otherwise the value is computed again with a few guard bits.
+// pi, log2, euler, catalan and e are computed on demand, other names are
+// whatever put() stored. Unlike the MPFR caches, free_cache() leaves the
+// store alone, and save() / load() carry it across processes as Float
+// binary images.
+class Constants
+{
+public:
+	typedef Float::prec_t prec_t;
+
+	// mpfr_const_* on the store, returns the ternary value
+	static int evaluate(const std::string &name, mpfr_ptr out, mpfr_rnd_t rnd);
+
+	// JS side: get rounds into out with its rounding, false when the name
+	// is unknown and not stored
+	static bool get(const std::string &name, Float &out);
+	// value must be rounded to nearest (error at most half an ulp), it
+	// replaces the stored one if more precise
+	static void put(const std::string &name, const Float &value);
+	static prec_t precision(const std::string &name);
+	static val names();
+	static void clear();
+
+	// "GMPC" 1, then per entry: name length (4 bytes), name, Float image
+	static val save();
+	// entries more precise than the stored ones are kept, returns how many
+	static int load(val bytes);
+
+private:
+	static std::map<std::string, Float> &store();
+	static bool round(const Float &stored, mpfr_ptr out, mpfr_rnd_t rnd, int &ternary);
+};
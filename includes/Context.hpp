@@ -0,0 +1,70 @@
+#pragma once
+
+#include <mpfr.h>
+#include <memory>
+#include <vector>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+#include "Float.hpp"
+
+// Default rounding, exponent range and flags of one logical computation.
+// MPFR keeps these process wide; a Scope installs a Context for its lifetime,
+// calling the MPFR setters only for the values that differ from the state
+// in place, and puts the outer state back on exit. Flags raised inside a
+// scope accumulate in the Context and do not leak to the outer state.
+// Floats keep their own rounding, RNDN by default, so internal temporaries
+// are unaffected; the entry points taking a Context (Float.sum and dot,
+// Formula.evaluateBatch, Quadrature.integrate) round their result with its
+// mode.
+class Context
+{
+public:
+	typedef Float::exp_t exp_t;
+	typedef Float::flags_t flags_t;
+	typedef void builder_pattern;
+
+	class Scope
+	{
+		Context &context;
+		Float::rnd_t rounding;
+		exp_t emin, emax;
+		flags_t flags;
+
+	public:
+		Scope(Context &context);
+		Scope(const Scope &) = delete;
+		Scope &operator=(const Scope &) = delete;
+		~Scope();
+	};
+
+private:
+	Float::rnd_t rounding;
+	exp_t emin, emax;
+	flags_t flags = 0;
+	int depth = 0;
+	std::vector<std::unique_ptr<Scope>> entered;
+
+public:
+	// starts from the current global state, without its flags
+	Context();
+
+	int getRounding() const;
+	builder_pattern setRounding(int mode);
+	exp_t getEmin() const;
+	builder_pattern setEmin(exp_t exp);
+	exp_t getEmax() const;
+	builder_pattern setEmax(exp_t exp);
+	flags_t getFlags() const;
+	builder_pattern clearFlags();
+	bool testFlags(flags_t mask) const;
+
+	// JS side scope, paired by context.run(callback) in FloatExtensions.js
+	// with try / finally since a JS exception skips the C++ destructors
+	builder_pattern enter();
+	builder_pattern exit();
+
+private:
+	static void install(Float::rnd_t rounding, exp_t emin, exp_t emax, flags_t flags);
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <mpfr.h>
+#include <gmp.h>
+#include <string>
+#include <vector>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+#include "Float.hpp"
+#include "FloatArray.hpp"
+
+// Convolution c_k = sum a_i b_k-i of two sequences, as in the product of
+// two series or polynomials.
+// "direct" sums the exact products with mpfr_sum, every c_k is correctly
+// rounded, in na nb products. The other methods turn each sequence into
+// integers times a common power of two, keeping all the bits of the
+// elements when they span at most precision + log2(n) + GUARD bits and
+// rounding below that otherwise, convolve the integers exactly and round
+// each c_k once: "karatsuba" recursively, "kronecker" by packing each
+// sequence into one integer of n slots and a single GMP multiplication
+// (FFT for the large sizes). The error is below
+// 2^-precision max |a_i| max |b_j| in addition to the final rounding, and
+// zero beyond it when no element was rounded.
+// "auto" picks direct for short or non-finite sequences and Kronecker
+// otherwise: Karatsuba beats direct from about 20 terms, but GMP under the
+// Kronecker substitution is faster still at every length measured.
+class Convolution
+{
+public:
+	typedef Float::prec_t prec_t;
+	typedef Float::exp_t exp_t;
+	typedef void builder_pattern;
+
+private:
+	prec_t precision;
+	Float::rnd_t rounding = MPFR_RNDN;
+	std::string method = "auto";
+	std::string used;
+
+public:
+	Convolution(prec_t precision);
+
+	prec_t getPrecision() const;
+	builder_pattern setPrecision(prec_t precision);
+	int getRounding() const;
+	builder_pattern setRounding(int mode);
+	// "auto", "direct", "karatsuba" or "kronecker"
+	std::string getMethod() const;
+	builder_pattern setMethod(std::string method);
+	// method of the last convolution
+	std::string getUsed() const;
+
+	// a and b are FloatArrays, Float64Arrays, or arrays of Floats and
+	// numbers, the result has length na + nb - 1
+	FloatArray convolve(val a, val b);
+
+	void convolve(const std::vector<mpfr_srcptr> &a, const std::vector<mpfr_srcptr> &b, FloatArray &out);
+};
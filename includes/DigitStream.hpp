@@ -0,0 +1,57 @@
+#pragma once
+
+#include <mpfr.h>
+#include <gmp.h>
+#include <string>
+#include <vector>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+#include "Float.hpp"
+
+// Produces the digits of a Float in bounded chunks, using a divide-and-conquer
+// base conversion instead of one big mpfr_get_str call.
+// The concatenation of all chunks has the same layout as Float::toString:
+// [-]d.ddddde(+|-)x, and @NaN@, @Inf@ or -@Inf@ for the special values
+class DigitStream
+{
+public:
+	typedef Float::exp_t exp_t;
+
+private:
+	struct Piece
+	{
+		__mpz_struct value;
+		size_t digits;
+	};
+
+	int base;
+	size_t chunk;
+	size_t ndigits;
+	exp_t exponent = 0;
+	bool negative = false;
+	bool started = false;
+	bool finished = false;
+	std::string special;
+	std::vector<Piece> pending;
+	std::vector<__mpz_struct> powers;
+	std::string buffer;
+
+public:
+	DigitStream(const Float &op, int base, int n, size_t chunk);
+	DigitStream(const DigitStream &) = delete;
+	DigitStream &operator=(const DigitStream &) = delete;
+	~DigitStream();
+
+	bool done() const;
+	val next();
+	exp_t getExponent() const;
+	size_t getDigits() const;
+
+private:
+	void scale(mpz_ptr out, mpz_srcptr mantissa, exp_t e2, exp_t e, mpfr_rnd_t rnd, bool neg);
+	mpz_srcptr power(size_t k);
+	void pushPiece(mpz_srcptr value, size_t digits);
+	void emitLeaf(Piece &leaf);
+};
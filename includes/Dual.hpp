@@ -0,0 +1,101 @@
+#pragma once
+
+#include <mpfr.h>
+#include <vector>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+#include "Float.hpp"
+#include "FloatArray.hpp"
+
+// Forward mode automatic differentiation: a value and its derivatives along
+// a fixed number of directions, all at the same precision. Every operation
+// updates the derivatives in the same call with the chain rule, so a
+// gradient of n inputs takes one pass with n directions instead of n + 1
+// Floats per intermediate result.
+// The value is rounded with the rounding mode like a Float, derivatives are
+// rounded to nearest and carry the usual floating point error of the chain
+// rule, not a correct rounding. Where the derivative is infinite (sqrt at
+// 0, log at 0...) the directions turn to infinities or NaN.
+// Operands of add, sub, mul, div and pow are Duals with the same number of
+// directions, or constants (numbers, Floats, strings, BigInts).
+class Dual
+{
+public:
+	typedef Float::prec_t prec_t;
+	typedef void builder_pattern;
+
+private:
+	Float value;
+	std::vector<Float> derivatives;
+	mpfr_rnd_t rounding = mpfr_get_default_rounding_mode();
+
+public:
+	Dual(size_t directions, prec_t precision);
+
+	size_t getDirections() const;
+	prec_t getPrecision() const;
+	int getRounding() const;
+	builder_pattern setRounding(int rounding);
+
+	// value v, derivative 1 along direction and 0 along the others, a
+	// negative direction makes a constant
+	builder_pattern seed(val v, int direction);
+	builder_pattern set(const Dual &other);
+	builder_pattern setValue(val v);
+	builder_pattern setDerivative(size_t direction, val v);
+	Float getValue() const;
+	Float getDerivative(size_t direction) const;
+	FloatArray gradient() const;
+
+	builder_pattern add(val v);
+	builder_pattern sub(val v);
+	builder_pattern mul(val v);
+	builder_pattern div(val v);
+	builder_pattern pow(val v);
+	builder_pattern pow_si(long n);
+	builder_pattern neg();
+	builder_pattern abs();
+	builder_pattern sqr();
+	builder_pattern sqrt();
+	builder_pattern cbrt();
+	builder_pattern exp();
+	builder_pattern exp2();
+	builder_pattern exp10();
+	builder_pattern expm1();
+	builder_pattern log();
+	builder_pattern log2();
+	builder_pattern log10();
+	builder_pattern log1p();
+	builder_pattern sin();
+	builder_pattern cos();
+	builder_pattern tan();
+	builder_pattern asin();
+	builder_pattern acos();
+	builder_pattern atan();
+	builder_pattern sinh();
+	builder_pattern cosh();
+	builder_pattern tanh();
+	builder_pattern asinh();
+	builder_pattern acosh();
+	builder_pattern atanh();
+	builder_pattern gamma();
+	builder_pattern lngamma();
+	builder_pattern eint();
+	builder_pattern li2();
+	builder_pattern erf();
+	builder_pattern erfc();
+	builder_pattern j0();
+	builder_pattern j1();
+	builder_pattern y0();
+	builder_pattern y1();
+
+private:
+	// the Dual behind v, or nullptr with the constant rounded into c
+	const Dual *operand(val v, Float &c) const;
+	// derivatives *= df
+	void chain(mpfr_srcptr df);
+	// y = f(x) becomes the value, derivative(df, x, y) gives f'(x)
+	void unary(int (*f)(mpfr_ptr, mpfr_srcptr, mpfr_rnd_t), void (*derivative)(mpfr_ptr df, mpfr_srcptr x, mpfr_srcptr y));
+};
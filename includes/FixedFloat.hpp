@@ -0,0 +1,287 @@
+#pragma once
+
+#include <mpfr.h>
+#include <gmp.h>
+
+// Fixed-size fast path for mid precisions (double-double, quad-double range).
+// FixedFloat<N> handles regular operands whose significands fit in N limbs:
+// the exact result is built in a fixed-size buffer and rounded once, so the
+// output, the ternary value and the inexact flag are the same as MPFR's.
+// Everything else (special values, wider operands, exponent out of range,
+// exact cancellation) returns false and is left to MPFR.
+template <int N>
+class FixedFloat
+{
+public:
+	typedef mp_limb_t limb_t;
+	typedef mpfr_exp_t exp_t;
+	static const int LIMB_BITS = GMP_NUMB_BITS;
+#if GMP_NUMB_BITS == 64
+	typedef unsigned __int128 dlimb_t;
+#else
+	typedef unsigned long long dlimb_t;
+#endif
+
+	static int limbs(mpfr_srcptr x) { return (mpfr_get_prec(x) - 1) / LIMB_BITS + 1; }
+
+	static bool fits(mpfr_srcptr out, mpfr_srcptr a, mpfr_srcptr b, mpfr_rnd_t rnd)
+	{
+		return limbs(out) == N && limbs(a) <= N && limbs(b) <= N &&
+			   mpfr_regular_p(a) && mpfr_regular_p(b) && rnd >= MPFR_RNDN && rnd <= MPFR_RNDF;
+	}
+
+	static bool mul(mpfr_ptr out, mpfr_srcptr a, mpfr_srcptr b, mpfr_rnd_t rnd, int &ternary)
+	{
+		if (!fits(out, a, b, rnd))
+			return false;
+		limb_t sx[N], sy[N], buf[2 * N];
+		const limb_t *x = load(sx, a), *y = load(sy, b);
+		for (int i = 0; i < 2 * N; i++)
+			buf[i] = 0;
+		for (int i = 0; i < N; i++)
+		{
+			limb_t carry = 0;
+			for (int j = 0; j < N; j++)
+			{
+				dlimb_t t = (dlimb_t)x[j] * y[i] + buf[i + j] + carry;
+				buf[i + j] = (limb_t)t;
+				carry = (limb_t)(t >> LIMB_BITS);
+			}
+			buf[i + N] = carry;
+		}
+		exp_t e = a->_mpfr_exp + b->_mpfr_exp;
+		if (!(buf[2 * N - 1] >> (LIMB_BITS - 1)))
+		{
+			shiftLeft<2 * N>(buf, 1);
+			e--;
+		}
+		return round<2 * N>(buf, false, MPFR_SIGN(a) != MPFR_SIGN(b), e, out, rnd, ternary);
+	}
+
+	// out = a + b, or a - b when negate is set
+	static bool add(mpfr_ptr out, mpfr_srcptr a, mpfr_srcptr b, bool negate, mpfr_rnd_t rnd, int &ternary)
+	{
+		if (!fits(out, a, b, rnd))
+			return false;
+		// carry limb, N limbs for the larger operand, one guard limb
+		const int M = N + 2;
+		limb_t sx[N], sy[N], buf[M], shifted[M];
+		const limb_t *x = load(sx, a), *y = load(sy, b);
+		bool na = MPFR_SIGN(a) < 0, nb = (MPFR_SIGN(b) < 0) != negate;
+
+		// order by magnitude, x >= y
+		int c = a->_mpfr_exp != b->_mpfr_exp ? (a->_mpfr_exp > b->_mpfr_exp ? 1 : -1) : compare(x, y);
+		if (c == 0 && na != nb)
+			return false;
+		bool negative = c >= 0 ? na : nb;
+		exp_t ex = c >= 0 ? a->_mpfr_exp : b->_mpfr_exp;
+		exp_t d = c >= 0 ? a->_mpfr_exp - b->_mpfr_exp : b->_mpfr_exp - a->_mpfr_exp;
+		const limb_t *hi = c >= 0 ? x : y, *lo = c >= 0 ? y : x;
+
+		buf[0] = buf[M - 1] = 0;
+		for (int i = 0; i < N; i++)
+			buf[i + 1] = hi[i];
+
+		// bits of the smaller operand falling below the guard limb only make a sticky bit
+		bool sticky = false;
+		if (d >= (exp_t)(N + 1) * LIMB_BITS)
+		{
+			sticky = true;
+			for (int i = 0; i < M; i++)
+				shifted[i] = 0;
+		}
+		else
+		{
+			// lo[i] lands in shifted[i + 1 - q] and, for s > 0, partly in the limb below
+			int q = d / LIMB_BITS, s = d % LIMB_BITS;
+			for (int j = 0; j < M; j++)
+			{
+				int i = j - 1 + q;
+				limb_t high = i >= 0 && i < N ? lo[i] : 0, low = i + 1 < N ? lo[i + 1] : 0;
+				shifted[j] = s ? (high >> s) | (low << (LIMB_BITS - s)) : high;
+			}
+			for (int i = 0; i < q - 1; i++)
+				sticky |= lo[i] != 0;
+			if (q && s)
+				sticky |= (limb_t)(lo[q - 1] << (LIMB_BITS - s)) != 0;
+		}
+
+		if (na == nb)
+		{
+			limb_t carry = 0;
+			for (int i = 0; i < M; i++)
+			{
+				limb_t t = buf[i] + carry;
+				carry = t < carry;
+				buf[i] = t + shifted[i];
+				carry += buf[i] < t;
+			}
+		}
+		else
+		{
+			// x - (y' + e) = (x - y' - 1) + (1 - e), the lost part stays sticky
+			limb_t borrow = sticky;
+			for (int i = 0; i < M; i++)
+			{
+				limb_t t = buf[i] - borrow;
+				borrow = buf[i] < borrow;
+				borrow += t < shifted[i];
+				buf[i] = t - shifted[i];
+			}
+		}
+
+		int top = M - 1;
+		while (top >= 0 && !buf[top])
+			top--;
+		if (top < 0)
+			return false;
+		int z = (M - 1 - top) * LIMB_BITS + clz(buf[top]);
+		if (z)
+			shiftLeft<M>(buf, z);
+		return round<M>(buf, sticky, negative, ex + LIMB_BITS - z, out, rnd, ternary);
+	}
+
+private:
+	// significand aligned on the top limb, copied into dst and zero padded
+	// below when the operand is narrower than N limbs
+	static const limb_t *load(limb_t *dst, mpfr_srcptr x)
+	{
+		int k = limbs(x);
+		if (k == N)
+			return x->_mpfr_d;
+		for (int i = 0; i < N - k; i++)
+			dst[i] = 0;
+		for (int i = 0; i < k; i++)
+			dst[N - k + i] = x->_mpfr_d[i];
+		return dst;
+	}
+
+	static int compare(const limb_t *x, const limb_t *y)
+	{
+		for (int i = N - 1; i >= 0; i--)
+			if (x[i] != y[i])
+				return x[i] > y[i] ? 1 : -1;
+		return 0;
+	}
+
+	static int clz(limb_t x)
+	{
+		if (sizeof(limb_t) == sizeof(unsigned long long))
+			return __builtin_clzll(x);
+		return __builtin_clz(x);
+	}
+
+	template <int M>
+	static void shiftLeft(limb_t *buf, int bits)
+	{
+		int q = bits / LIMB_BITS, s = bits % LIMB_BITS;
+		for (int i = M - 1; i >= 0; i--)
+		{
+			limb_t v = i - q >= 0 ? buf[i - q] << s : 0;
+			if (s && i - q - 1 >= 0)
+				v |= buf[i - q - 1] >> (LIMB_BITS - s);
+			buf[i] = v;
+		}
+	}
+
+	// buf is normalized (top bit of buf[M - 1] set), keeps the top N limbs,
+	// sticky tells whether nonzero bits were dropped below buf
+	template <int M>
+	static bool round(limb_t *buf, bool sticky, bool negative, exp_t e, mpfr_ptr out, mpfr_rnd_t rnd, int &ternary)
+	{
+		int sh = N * LIMB_BITS - mpfr_get_prec(out);
+		limb_t *r = buf + M - N;
+		bool rb;
+		if (sh)
+		{
+			limb_t mask = ((limb_t)1 << sh) - 1;
+			rb = (r[0] >> (sh - 1)) & 1;
+			sticky |= (r[0] & (mask >> 1)) != 0;
+			r[0] &= ~mask;
+			for (int i = 0; i < M - N && !sticky; i++)
+				sticky = buf[i] != 0;
+		}
+		else
+		{
+			const limb_t half = (limb_t)1 << (LIMB_BITS - 1);
+			rb = buf[M - N - 1] & half;
+			sticky |= (buf[M - N - 1] & (half - 1)) != 0;
+			for (int i = 0; i < M - N - 1 && !sticky; i++)
+				sticky = buf[i] != 0;
+		}
+
+		bool inexact = rb || sticky, up = false;
+		if (inexact)
+			switch (rnd)
+			{
+			case MPFR_RNDN:
+				up = rb && (sticky || ((r[0] >> sh) & 1));
+				break;
+			case MPFR_RNDU:
+				up = !negative;
+				break;
+			case MPFR_RNDD:
+				up = negative;
+				break;
+			case MPFR_RNDA:
+				up = true;
+				break;
+			default:
+				break;
+			}
+
+		if (up)
+		{
+			limb_t carry = (limb_t)1 << sh;
+			for (int i = 0; i < N && carry; i++)
+			{
+				r[i] += carry;
+				carry = r[i] < carry;
+			}
+			if (carry)
+			{
+				r[N - 1] = (limb_t)1 << (LIMB_BITS - 1);
+				e++;
+			}
+		}
+
+		if (e < mpfr_get_emin() || e > mpfr_get_emax())
+			return false;
+		for (int i = 0; i < N; i++)
+			out->_mpfr_d[i] = r[i];
+		out->_mpfr_exp = e;
+		MPFR_SIGN(out) = negative ? -1 : 1;
+		ternary = inexact ? (up != negative ? 1 : -1) : 0;
+		if (inexact)
+			mpfr_set_inexflag();
+		return true;
+	}
+};
+
+// picks the specialization from the output precision, 4 limbs and more:
+// MPFR already has dedicated code for one to three limbs
+namespace FixedPrecision
+{
+	const int MIN_LIMBS = 4;
+	const int MAX_LIMBS = 256 / GMP_NUMB_BITS;
+
+	template <int N = MIN_LIMBS>
+	bool mul(mpfr_ptr out, mpfr_srcptr a, mpfr_srcptr b, mpfr_rnd_t rnd, int &ternary)
+	{
+		if (FixedFloat<N>::limbs(out) == N)
+			return FixedFloat<N>::mul(out, a, b, rnd, ternary);
+		if constexpr (N < MAX_LIMBS)
+			return mul<N + 1>(out, a, b, rnd, ternary);
+		return false;
+	}
+
+	template <int N = MIN_LIMBS>
+	bool add(mpfr_ptr out, mpfr_srcptr a, mpfr_srcptr b, bool negate, mpfr_rnd_t rnd, int &ternary)
+	{
+		if (FixedFloat<N>::limbs(out) == N)
+			return FixedFloat<N>::add(out, a, b, negate, rnd, ternary);
+		if constexpr (N < MAX_LIMBS)
+			return add<N + 1>(out, a, b, negate, rnd, ternary);
+		return false;
+	}
+}
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <mpfr.h>
+#include <cstdint>
 #include <iostream>
+#include <vector>
 #include <emscripten/val.h>
 
 using namespace emscripten;
@@ -9,6 +11,8 @@ using namespace emscripten;
 #include "Float.hpp"
 #include "utils.hpp"
 
+class Context;
+
 class Float
 {
 
@@ -47,15 +51,30 @@ public:
 	builder_pattern setSign(sign_t sign);
 	size_t getMantissaSize() const;
 	val getMantissaView();
+	mpfr_ptr ptr();
+	mpfr_srcptr ptr() const;
 	builder_pattern setString(const std::string &str);
 	builder_pattern setString(const std::string &str, int base);
 	builder_pattern setDouble(double x);
 	builder_pattern setFloat(const Float &tocopy);
+	builder_pattern setBigInt(val bigint);
+	builder_pattern setBigInt(val bigint, exp_t scale);
 	builder_pattern set(val v);
 	std::string toString(int base);
 	std::string toString();
 	std::string toString(int base, int n);
 	double toNumber();
+	// binary image keeping the precision, rounding and every bit of the
+	// value, to move Floats between module instances (workers, storage)
+	val toBinary();
+	static Float fromBinary(val bytes);
+	// exact exchange with JS BigInt, value * 2^scale, see Float.cpp
+	static Float fromBigInt(val bigint, prec_t precision);
+	static Float fromBigInt(val bigint, prec_t precision, exp_t scale);
+	val toBigInt();
+	val toBigInt(exp_t scale);
+	void writeBinary(std::vector<uint8_t> &out) const;
+	size_t readBinary(const uint8_t *data, size_t size);
 	bool isInteger();
 	bool isNaN();
 	bool isInfinity();
@@ -65,6 +84,9 @@ public:
 	static int op_cmp_abs();
 	static int op_cmp_abs_ui();
 	bool less_greater(const Float &);
+	// equal Floats hash equal whatever their precision, see Float.cpp
+	uint32_t hash() const;
+	static uint32_t hash(mpfr_srcptr x);
 
 	bool operator<(const Float &op) const;
 	bool operator==(const Float &op) const;
@@ -203,6 +225,9 @@ public:
 	static int op_hypot(Float &out, const Float &x, const Float &y);
 	static int op_sum(Float &out, val iterable);
 	static int op_dot(Float &out, val a, val b);
+	// same under context, rounded with its rounding mode
+	static int op_sum(Float &out, val iterable, Context &context);
+	static int op_dot(Float &out, val a, val b, Context &context);
 
 	// Integer & Remainders
 
@@ -341,4 +366,6 @@ public:
 
 private:
 	static void jsArrayToMpfrArray(emscripten::val array, mpfr_ptr *out, int length);
+	static int sum(Float &out, val array, rnd_t rnd);
+	static int dot(Float &out, val a, val b, rnd_t rnd);
 };
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <mpfr.h>
+#include <vector>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+#include "Float.hpp"
+
+// Contiguous batch of Floats owned natively, so whole-array operations run
+// without a binding call per element. Elements are plain mpfr structs:
+// reordering them only swaps limb pointers.
+// Ordering is mpfr_total_order_p: -NaN < -Inf < ... < -0 < +0 < ... < +Inf < +NaN
+class FloatArray
+{
+public:
+	typedef Float::prec_t prec_t;
+	typedef void builder_pattern;
+
+private:
+	std::vector<__mpfr_struct> items;
+	Float::rnd_t rounding = MPFR_RNDN;
+
+public:
+	FloatArray(size_t length, prec_t precision);
+	FloatArray(const FloatArray &);
+	FloatArray(FloatArray &&);
+	FloatArray &operator=(const FloatArray &) = delete;
+	~FloatArray();
+
+	// Float64Array, or array of Floats, numbers and strings
+	static FloatArray from(val array, prec_t precision);
+	// Float64Array of (hi, lo) pairs, each element is hi + lo
+	static FloatArray fromDoubleDouble(val pairs, prec_t precision);
+
+	size_t getLength() const;
+	int getRounding() const;
+	builder_pattern setRounding(int mode);
+	Float get(size_t i) const;
+	builder_pattern set(size_t i, val v);
+
+	builder_pattern sort();
+	builder_pattern stableSort();
+	val argsort(bool stable) const;
+	int lowerBound(val v) const;
+	int upperBound(val v) const;
+	int argmin() const;
+	int argmax() const;
+	Float min() const;
+	Float max() const;
+	Float select(size_t k);
+
+	// Every element rounded to double with the array rounding, into out or
+	// a new Float64Array. An out viewing the module memory is written in
+	// place, any other goes through a single copy.
+	val toFloat64Array() const;
+	val toFloat64Array(val out) const;
+	// interleaved hi, lo with hi = x rounded to nearest and lo = x - hi
+	// rounded to nearest, exact while x fits in 106 bits and lo is normal
+	val toDoubleDouble() const;
+	val toDoubleDouble(val out) const;
+
+	// raw access for the other native classes
+	size_t size() const;
+	mpfr_ptr at(size_t i);
+	mpfr_srcptr at(size_t i) const;
+
+private:
+	static bool less(const __mpfr_struct &a, const __mpfr_struct &b);
+	bool check(size_t i) const;
+	int extremum(int sign) const;
+};
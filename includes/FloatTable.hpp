@@ -0,0 +1,98 @@
+#pragma once
+
+#include <mpfr.h>
+#include <cstdint>
+#include <vector>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+#include "Float.hpp"
+
+// Open addressing hash table keyed by Float values (linear probing,
+// tombstones, at most 3/4 full). Keys match when mpfr_equal_p holds or both
+// are NaN, the SameValueZero rule of JS Map: +0 and -0 are one key and NaN
+// is a key. Keys are copied at their own precision, so 1 at 53 bits and 1
+// at 1000 bits are the same key.
+class FloatTable
+{
+public:
+	typedef Float::prec_t prec_t;
+
+protected:
+	enum State : uint8_t
+	{
+		Empty,
+		Full,
+		Deleted
+	};
+	struct Slot
+	{
+		__mpfr_struct key;
+		uint32_t hash;
+		State state;
+	};
+	std::vector<Slot> slots;
+	size_t count = 0;
+	size_t used = 0;
+
+public:
+	FloatTable();
+	FloatTable(const FloatTable &) = delete;
+	FloatTable &operator=(const FloatTable &) = delete;
+	virtual ~FloatTable();
+
+protected:
+	// the keys as new Floats
+	val copyKeys() const;
+	// slot of key, or -1
+	long find(mpfr_srcptr key) const;
+	// slot of key, added when missing
+	size_t insert(mpfr_srcptr key, bool &inserted);
+	// slot freed, or -1
+	long erase(mpfr_srcptr key);
+	void reset();
+	// after a rehash the entry of slot i is at moves[i] of capacity slots
+	virtual void relocate(const std::vector<long> &moves, size_t capacity);
+
+private:
+	void rehash(size_t capacity);
+};
+
+class FloatSet : public FloatTable
+{
+public:
+	typedef void builder_pattern;
+
+	size_t getSize() const;
+	bool add(const Float &key);
+	// FloatArray or array of Floats, returns how many were new
+	int addAll(val keys);
+	bool has(const Float &key) const;
+	bool remove(const Float &key);
+	builder_pattern clear();
+	val values() const;
+};
+
+class FloatMap : public FloatTable
+{
+public:
+	typedef void builder_pattern;
+
+private:
+	std::vector<val> values;
+
+public:
+	size_t getSize() const;
+	builder_pattern set(const Float &key, val value);
+	// undefined when missing
+	val get(const Float &key) const;
+	bool has(const Float &key) const;
+	bool remove(const Float &key);
+	builder_pattern clear();
+	val keys() const;
+	val entries() const;
+
+protected:
+	void relocate(const std::vector<long> &moves, size_t capacity) override;
+};
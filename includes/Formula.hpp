@@ -0,0 +1,107 @@
+#pragma once
+
+#include <mpfr.h>
+#include <string>
+#include <vector>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+#include "Float.hpp"
+#include "FloatArray.hpp"
+#include "Context.hpp"
+
+// Expression compiled once from a string such as "exp(-x^2) * sin(y)" into a
+// tape for a small stack machine, then evaluated natively at any precision.
+// Syntax: numbers, the declared variables, pi, e, + - * / ^ (right
+// associative), parentheses, the functions of the tables below.
+class Formula
+{
+public:
+	typedef Float::prec_t prec_t;
+	typedef void builder_pattern;
+	typedef int (*unary_t)(Float &, const Float &);
+	typedef int (*binary_t)(mpfr_ptr, mpfr_srcptr, mpfr_srcptr, mpfr_rnd_t);
+
+	enum Op
+	{
+		Variable,
+		Constant,
+		Neg,
+		Add,
+		Sub,
+		Mul,
+		Div,
+		Pow,
+		PowInt,
+		Call,
+		Call2
+	};
+
+	// operands are read from slot and slot + 1, the result goes to slot.
+	// arg is the variable, constant or function index, or the integer exponent
+	struct Instruction
+	{
+		Op op;
+		int slot;
+		long arg;
+	};
+
+	struct Function
+	{
+		const char *name;
+		unary_t fn;
+	};
+
+	struct Function2
+	{
+		const char *name;
+		binary_t fn;
+	};
+
+	static const Function functions[];
+	static const Function2 functions2[];
+
+private:
+	std::vector<std::string> variables;
+	std::vector<std::string> literals;
+	std::vector<Instruction> tape;
+	int depth = 0;
+	std::string error;
+	prec_t prepared = 0;
+	std::vector<Float> constants;
+	std::vector<Float> stack;
+
+public:
+	Formula(const std::string &source, val variables);
+	Formula(const std::string &source, const std::vector<std::string> &variables);
+
+	bool isValid() const;
+	std::string getError() const;
+	int getVariableCount() const;
+
+	// args is an array of Floats and numbers, one per variable
+	int evaluate(Float &out, val args);
+	// columns is an array of FloatArrays, one per variable, out[i] gets row i
+	builder_pattern evaluateBatch(val columns, FloatArray &out);
+	// same under context, rounded with its rounding mode
+	builder_pattern evaluateBatch(val columns, FloatArray &out, Context &context);
+
+	// native evaluation at the precision of out. precisions, when given,
+	// holds one precision per instruction and each result is rounded to it
+	// (see PrecisionAnalyzer)
+	int evaluate(mpfr_srcptr const *args, mpfr_ptr out, mpfr_rnd_t rnd, const prec_t *precisions = nullptr);
+	// Floats and numbers of a JS array, numbers are kept in holder
+	static std::vector<mpfr_srcptr> arguments(val args, std::vector<Float> &holder);
+	// "add", "sin", "x", "pi", "^3"... for instruction index
+	std::string describe(size_t index) const;
+	const std::vector<Instruction> &getTape() const;
+	int getDepth() const;
+	void constant(int index, mpfr_ptr out) const;
+
+private:
+	void compile(const std::string &source);
+	void batch(val columns, FloatArray &out, mpfr_rnd_t rnd);
+	void prepare(prec_t precision);
+	friend struct FormulaParser;
+};
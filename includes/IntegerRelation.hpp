@@ -0,0 +1,62 @@
+#pragma once
+
+#include <mpfr.h>
+#include <gmp.h>
+#include <vector>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+#include "Float.hpp"
+
+// Integer relations a1 x1 + ... + an xn = 0 between numbers known to
+// precision bits.
+// pslq runs the PSLQ iteration of Ferguson and Bailey on two levels: most
+// iterations update a 128-bit copy of H along with the integer matrices A
+// and B, and once their entries reach 48 bits the full precision y, H, A and
+// B are brought up to date (H by an LQ decomposition of A H) and checked for
+// a relation. Short precisions run every iteration at full precision.
+// lll reduces the lattice of the rows (e_i, 2^precision x_i) with the
+// integral LLL of Cohen (Algorithm 2.6.7), exact over GMP integers.
+// Both return the relation as an array of BigInts, empty when none is found
+// within the precision, and set bound: no relation has a smaller Euclidean
+// norm (for lll, no relation independent of the returned one).
+// Exact relations among p-bit numbers exist from about p / (n - 1) bits, so a
+// relation is only returned when it stands out from them: for pslq min |y|
+// has to drop by 80 bits at once when it is found, for lll its norm has to
+// be 2^16 times below bound. Below about 100 bits pslq finds nothing.
+class IntegerRelation
+{
+public:
+	typedef Float::prec_t prec_t;
+	typedef void builder_pattern;
+
+private:
+	prec_t precision;
+	int maxIterations = 1000000;
+	int iterations = 0;
+	bool found = false;
+	Float bound{53};
+	Float residual{53};
+
+	val relation(const std::vector<mpz_srcptr> &a, const std::vector<mpfr_srcptr> &x);
+
+public:
+	IntegerRelation(prec_t precision);
+
+	prec_t getPrecision() const;
+	builder_pattern setPrecision(prec_t precision);
+	int getMaxIterations() const;
+	builder_pattern setMaxIterations(int n);
+
+	// statistics of the last search
+	int getIterations() const;
+	bool isFound() const;
+	Float getBound() const;
+	// |a1 x1 + ... + an xn| for the returned relation
+	Float getResidual() const;
+
+	// x is a FloatArray, a Float64Array, or an array of Floats and numbers
+	val pslq(val x);
+	val lll(val x);
+};
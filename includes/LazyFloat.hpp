@@ -0,0 +1,163 @@
+#pragma once
+
+#include <mpfr.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+#include "Float.hpp"
+
+// Opt-in lazy counterpart of Float: builder calls record a small DAG which is
+// only executed when the value is observed (toString, toNumber, comparisons).
+// Evaluation fuses
+//   a*b + c, c + a*b -> fma        a*b - c -> fms
+//   a*b + c*d        -> fmma       a*b - c*d -> fmms
+//   x*x              -> sqr
+//   sin(x), cos(x)   -> sin_cos    sinh(x), cosh(x) -> sinh_cosh
+// so the fused result is rounded once, which can differ from the eager Float.
+class LazyFloat
+{
+public:
+	typedef Float::prec_t prec_t;
+	typedef int (*unary_t)(Float &, const Float &);
+	typedef void builder_pattern;
+
+private:
+	enum Kind
+	{
+		Leaf,
+		Unary,
+		Add,
+		Sub,
+		Mul,
+		Div
+	};
+
+	struct Node
+	{
+		Kind kind = Leaf;
+		unary_t unary = nullptr;
+		std::shared_ptr<Node> a, b;
+		prec_t precision;
+		int rounding;
+		std::unique_ptr<Float> value;
+		std::vector<std::weak_ptr<Node>> users;
+
+		~Node();
+	};
+
+	struct Plan
+	{
+		enum
+		{
+			Direct,
+			Sqr,
+			Fma,
+			Fms,
+			Fmma,
+			Fmms
+		} kind = Direct;
+		Node *inputs[4];
+		int count = 0;
+	};
+
+	std::shared_ptr<Node> node;
+	prec_t precision;
+	int rounding;
+
+public:
+	LazyFloat(val);
+	LazyFloat(const Float &);
+	LazyFloat(const LazyFloat &) = default;
+
+	int getRounding() const;
+	builder_pattern setRounding(int mode);
+	prec_t getPrecision() const;
+	builder_pattern setPrecision(prec_t precision);
+	bool isPending() const;
+
+	builder_pattern set(val v);
+	builder_pattern add(val v);
+	builder_pattern sub(val v);
+	builder_pattern mul(val v);
+	builder_pattern div(val v);
+	builder_pattern fma(val a, val b);
+	builder_pattern fms(val a, val b);
+	builder_pattern fmma(val a, val b, val c);
+	builder_pattern fmms(val a, val b, val c);
+
+	builder_pattern sqr();
+	builder_pattern sqrt();
+	builder_pattern rec_sqrt();
+	builder_pattern cbrt();
+	builder_pattern neg();
+	builder_pattern abs();
+	builder_pattern log();
+	builder_pattern log2();
+	builder_pattern log10();
+	builder_pattern log1p();
+	builder_pattern exp();
+	builder_pattern exp2();
+	builder_pattern exp10();
+	builder_pattern expm1();
+	builder_pattern cos();
+	builder_pattern sin();
+	builder_pattern tan();
+	builder_pattern sec();
+	builder_pattern csc();
+	builder_pattern cot();
+	builder_pattern acos();
+	builder_pattern asin();
+	builder_pattern atan();
+	builder_pattern cosh();
+	builder_pattern sinh();
+	builder_pattern tanh();
+	builder_pattern sech();
+	builder_pattern csch();
+	builder_pattern coth();
+	builder_pattern acosh();
+	builder_pattern asinh();
+	builder_pattern atanh();
+	builder_pattern eint();
+	builder_pattern li2();
+	builder_pattern gamma();
+	builder_pattern lngamma();
+	builder_pattern digamma();
+	builder_pattern zeta();
+	builder_pattern erf();
+	builder_pattern erfc();
+	builder_pattern j0();
+	builder_pattern j1();
+	builder_pattern y0();
+	builder_pattern y1();
+	builder_pattern ai();
+
+	// observation, forces the evaluation
+	const Float &value();
+	Float toFloat();
+	std::string toString(int base, int n);
+	std::string toString(int base);
+	std::string toString();
+	double toNumber();
+	bool less(val v);
+	bool greater(val v);
+	bool less_equal(val v);
+	bool greater_equal(val v);
+	bool equal(val v);
+	bool not_equal(val v);
+
+private:
+	static std::shared_ptr<Node> leaf(const Float &op);
+	std::shared_ptr<Node> operand(val v) const;
+	std::shared_ptr<Node> binary(Kind kind, std::shared_ptr<Node> a, std::shared_ptr<Node> b) const;
+	void unary(unary_t fn);
+	static const Float &evaluate(const std::shared_ptr<Node> &root);
+	static Plan plan(Node *n);
+	static void compute(Node *n);
+	static Node *sibling(Node *n, unary_t pair);
+	static void settle(Node *n);
+	static int compare(LazyFloat &self, val v);
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <mpfr.h>
+#include <cstddef>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+// Accounting of every GMP / MPFR allocation through mp_set_memory_functions,
+// against an optional budget in bytes (0, the default, is no limit).
+// The budget is enforced at the safe points only, where a Float is about to
+// be created: the allocation hooks count but never throw, since a JS
+// exception from inside GMP would skip the destructors of the C++
+// temporaries and leave MPFR caches half initialized.
+// - Past trimRatio of the budget a trim is scheduled: mpfr_free_cache and
+//   the Quadrature nodes are dropped at the next safe point, never in the
+//   middle of an MPFR call that may use them.
+// - The JS entry points that create Floats (Float and FloatArray
+//   constructors, precision setter, FloatArray.from) call check() first and
+//   throw a JS RangeError when they would not fit, after a trim, with
+//   nothing built yet.
+// - Native code calls admit(), which never throws: a Float refused there
+//   logs an error and is a NaN of precision MPFR_PREC_MIN. The temporaries
+//   of one operation can go past the budget.
+// - A real allocation failure in a hook frees the MPFR pool and retries,
+//   then aborts.
+// The constant store is user data and is not trimmed.
+class Memory
+{
+public:
+	typedef mpfr_prec_t prec_t;
+
+	static size_t getUsed();
+	static size_t getPeak();
+	static size_t getBudget();
+	static void setBudget(size_t bytes);
+	static double getTrimRatio();
+	static void setTrimRatio(double ratio);
+	static void resetPeak();
+	static void trim();
+
+	// safe point before count Floats of precision prec are allocated,
+	// false (with an error logged) when they do not fit
+	static bool admit(prec_t prec, size_t count = 1);
+	// same at a JS entry point, throws a RangeError instead
+	static void check(prec_t prec, size_t count = 1);
+
+private:
+	static void *allocate(size_t size);
+	static void *reallocate(void *ptr, size_t old, size_t size);
+	static void release(void *ptr, size_t size);
+	static void account(size_t size);
+	static const char *refuse(prec_t prec, size_t count);
+	friend struct MemoryHooks;
+};
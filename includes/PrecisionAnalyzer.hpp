@@ -0,0 +1,59 @@
+#pragma once
+
+#include <mpfr.h>
+#include <vector>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+#include "Float.hpp"
+#include "Formula.hpp"
+
+// Finds how many bits each instruction of a Formula needs. The formula is
+// evaluated once at the target plus guard bits as the reference, then again
+// with the result of one instruction rounded to a lower precision, searched
+// by bisection, the others staying at the reference precision. A run is
+// accurate when it differs from the reference by less than 2^-bits
+// relative, judged on the exponent of the difference.
+// The per instruction minima ignore how errors add up, so the joint
+// assignment raises them all by 1, 2, 4... bits until the whole formula is
+// accurate again. The uniform precision is the smallest one that works for
+// every instruction at once, for comparison.
+// Results hold for the point analyzed; take the maximum over a few points
+// for a range of inputs.
+class PrecisionAnalyzer
+{
+public:
+	typedef Float::prec_t prec_t;
+	typedef void builder_pattern;
+
+private:
+	// a copy: the analyzer does not depend on the JS owned Formula
+	Formula formula;
+	prec_t guard = 64;
+	prec_t reference = 0;
+	std::vector<prec_t> minimal;
+	std::vector<prec_t> joint;
+	prec_t uniform = 0;
+
+public:
+	PrecisionAnalyzer(const Formula &formula);
+
+	prec_t getGuard() const;
+	builder_pattern setGuard(prec_t guard);
+
+	// { bits, reference, uniform, operations: [{ index, op, minimal, joint }] }
+	// for the decimal digits wanted at the point args
+	val analyze(val args, int digits);
+	// native analysis for a result accurate to bits, false if the formula
+	// cannot be evaluated there
+	bool analyze(mpfr_srcptr const *args, prec_t bits);
+
+	prec_t getReference() const;
+	prec_t getUniform() const;
+	const std::vector<prec_t> &getMinimal() const;
+	const std::vector<prec_t> &getJoint() const;
+
+private:
+	bool accurate(mpfr_srcptr const *args, const std::vector<prec_t> &precisions, mpfr_srcptr expected, prec_t bits);
+};
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <mpfr.h>
+#include <functional>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+#include "Float.hpp"
+#include "FloatArray.hpp"
+#include "Context.hpp"
+
+// Adaptive quadrature over a finite interval. The rule is refined level by
+// level (Gauss-Legendre: 3 * 2^level points, tanh-sinh: step 2^-level reusing
+// the previous points) until two successive estimates agree to the target
+// precision. Abscissas and weights only depend on (rule, level, precision):
+// they are computed once and shared by every Quadrature of the module.
+// The integrand is a Formula of one variable, evaluated natively, or a JS
+// callback f(xs, ys) filling the FloatArray ys with f at the points xs, called
+// once per level.
+// Tanh-sinh copes with integrable end point singularities, with about half the
+// precision when the integrand recomputes the distance to the end (1 - x).
+class Quadrature
+{
+public:
+	typedef Float::prec_t prec_t;
+	typedef void builder_pattern;
+	typedef std::function<void(const FloatArray &, FloatArray &)> sampler_t;
+
+	enum Rule
+	{
+		GaussLegendre,
+		TanhSinh
+	};
+
+	// positive half of a symmetric rule: x, 1 - x and w for each point, plus
+	// the weight of the center point, zero if the rule has none
+	struct Nodes
+	{
+		FloatArray x, c, w;
+		Float center;
+
+		Nodes(size_t length, prec_t precision);
+	};
+
+private:
+	static std::map<std::tuple<int, int, prec_t>, std::shared_ptr<const Nodes>> cache;
+
+	Rule rule;
+	prec_t precision;
+	int maxLevel;
+	int levels = 0;
+	Float error;
+
+public:
+	Quadrature(int rule, prec_t precision);
+
+	prec_t getPrecision() const;
+	builder_pattern setPrecision(prec_t precision);
+	int getMaxLevel() const;
+	builder_pattern setMaxLevel(int level);
+	int getLevels() const;
+	Float getError() const;
+
+	Float integrate(val f, val a, val b);
+	// same under context, rounded with its rounding mode
+	Float integrate(val f, val a, val b, Context &context);
+	// native integrand, fills ys with f at the points xs
+	Float integrate(const sampler_t &f, mpfr_srcptr a, mpfr_srcptr b);
+	Float integrate(const sampler_t &f, mpfr_srcptr a, mpfr_srcptr b, Float::rnd_t rnd);
+
+	static size_t cacheSize();
+	static void clearCache();
+	static std::shared_ptr<const Nodes> nodes(Rule rule, int level, prec_t precision);
+
+private:
+	static std::shared_ptr<Nodes> gaussLegendre(int n, prec_t precision);
+	static std::shared_ptr<Nodes> tanhSinh(int level, prec_t precision);
+	static void evaluate(val f, const FloatArray &xs, FloatArray &ys);
+};
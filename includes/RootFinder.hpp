@@ -0,0 +1,51 @@
+#pragma once
+
+#include <mpfr.h>
+#include <functional>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+#include "Float.hpp"
+
+// Newton iteration with precision doubling: the first steps run at low
+// precision and each step lifts the iterate (op_prec_round) to about twice
+// the precision, as quadratic convergence allows, up to the target plus a
+// few guard bits. Iterations stop once op_can_round certifies the result
+// from the size of the last correction.
+class RootFinder
+{
+public:
+	typedef Float::prec_t prec_t;
+	typedef void builder_pattern;
+	// fills y = f(x) and dy = f'(x) at the precision of y
+	typedef std::function<void(const Float &x, Float &y, Float &dy)> function_t;
+
+private:
+	prec_t precision;
+	Float::rnd_t rounding = MPFR_RNDN;
+	int maxIterations = 100;
+	int iterations = 0;
+	bool converged = false;
+
+public:
+	RootFinder(prec_t precision);
+
+	prec_t getPrecision() const;
+	builder_pattern setPrecision(prec_t precision);
+	int getRounding() const;
+	builder_pattern setRounding(int mode);
+	int getMaxIterations() const;
+	builder_pattern setMaxIterations(int n);
+	int getIterations() const;
+	bool isConverged() const;
+
+	// f and df are one variable Formulas, or f is a JS callback f(x, y, dy)
+	// filling the Floats y and dy, and df is ignored
+	Float solve(val f, val df, val guess);
+	// root of sum c[i] x^i near guess, coefficients as a FloatArray or an
+	// array of Floats and numbers
+	Float polynomial(val coefficients, val guess);
+
+	Float newton(const function_t &f, const Float &guess);
+};
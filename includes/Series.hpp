@@ -0,0 +1,73 @@
+#pragma once
+
+#include <mpfr.h>
+#include <gmp.h>
+#include <string>
+#include <vector>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+#include "Float.hpp"
+
+// Partial products of a series over [begin, end), see Series
+class SeriesRange
+{
+public:
+	__mpz_struct P, Q, T;
+	unsigned long begin, end;
+
+	SeriesRange(unsigned long begin, unsigned long end);
+	SeriesRange(const SeriesRange &);
+	SeriesRange &operator=(const SeriesRange &) = delete;
+	~SeriesRange();
+
+	unsigned long getBegin() const;
+	unsigned long getEnd() const;
+	// "begin:end:P:Q:T" in base 32, to hand a range over to another worker
+	std::string serialize() const;
+	static SeriesRange deserialize(const std::string &text);
+};
+
+// Binary splitting for S = sum_n>=0 a(n) prod_k=1..n p(k) / q(k), with a, p
+// and q integer polynomials given by their coefficients, lowest degree first,
+// as numbers or decimal strings. For instance e = sum 1/n! is p = [1],
+// q = [0, 1], a = [1].
+// [begin, end) is reduced to the integers P = prod p, Q = prod q and
+// T = sum a(n) p(begin)..p(n) q(n+1)..q(end-1), combined pairwise so the work
+// goes to a few large GMP multiplications. Ranges can be computed
+// separately (in workers) and merged with Series.combine.
+class Series
+{
+public:
+	typedef Float::prec_t prec_t;
+
+private:
+	std::vector<__mpz_struct> p, q, a;
+	int guard = 32;
+
+public:
+	Series(val p, val q, val a);
+	Series(const Series &) = delete;
+	Series &operator=(const Series &) = delete;
+	~Series();
+
+	// number of terms for a truncation error 2^-precision relative to the largest term
+	unsigned long terms(prec_t precision) const;
+	SeriesRange range(unsigned long begin, unsigned long end) const;
+	static SeriesRange combine(const SeriesRange &left, const SeriesRange &right);
+	// T / Q of a range starting at 0, rounded to precision
+	static Float value(const SeriesRange &range, prec_t precision, int rounding);
+	// sum to precision, with the rounding checked by mpfr_can_round and
+	// more terms when it fails
+	Float evaluate(prec_t precision, int rounding);
+
+private:
+	static void polynomial(mpz_ptr out, const std::vector<__mpz_struct> &c, unsigned long n);
+	static double logPolynomial(const std::vector<__mpz_struct> &c, unsigned long n);
+	static double logBound(const std::vector<__mpz_struct> &c, unsigned long n);
+	// terms() along with log2 of the largest term and of a bound on the tail
+	unsigned long truncation(prec_t precision, double &largest, double &tail) const;
+	void split(unsigned long begin, unsigned long end, mpz_ptr P, mpz_ptr Q, mpz_ptr T) const;
+	static std::vector<__mpz_struct> coefficients(val v);
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <mpfr.h>
+#include <gmp.h>
+#include <vector>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+#include "Float.hpp"
+
+// Mean, variance, covariance and central moments with a single rounding.
+// The power and product sums are kept exact in Accumulators (the fixed
+// point path for Float64Arrays, products of doubles included), combined
+// exactly as integers times powers of two, and only the final quotient is
+// rounded, so results are correctly rounded whatever the size and the
+// cancellation of the data, within the WIDTH cap of the Accumulator: data
+// spread over more than precision + 2^16 bits keeps a sticky bit for the
+// smallest values. For instance the variance is
+// (n sum x^2 - (sum x)^2) / (n (n - ddof)).
+// Samples are Float64Arrays, FloatArrays, or arrays of Floats and numbers.
+// NaN or infinite samples give NaN, except for the mean which follows the
+// rules of the sum.
+class Statistics
+{
+public:
+	typedef Float::prec_t prec_t;
+	typedef Float::exp_t exp_t;
+	typedef void builder_pattern;
+
+private:
+	prec_t precision;
+	Float::rnd_t rounding = MPFR_RNDN;
+
+public:
+	Statistics(prec_t precision);
+
+	prec_t getPrecision() const;
+	builder_pattern setPrecision(prec_t precision);
+	int getRounding() const;
+	builder_pattern setRounding(int mode);
+
+	Float mean(val x);
+	// ddof 0 for the population variance, 1 for the sample variance
+	Float variance(val x, int ddof);
+	Float covariance(val x, val y, int ddof);
+	// (1 / n) sum (x - mean)^k
+	Float moment(val x, int k);
+
+	// frequency weights, population forms: sum w (x - m)^2 / sum w
+	Float weightedMean(val x, val w);
+	Float weightedVariance(val x, val w);
+	Float weightedCovariance(val x, val y, val w);
+};
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <mpfr.h>
+#include <string>
+#include <vector>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+#include "Float.hpp"
+#include "FloatArray.hpp"
+#include "Formula.hpp"
+
+// Taylor method for y' = f(t, y), one Formula per component over the
+// variables (t, y1 ... yn). The tapes are lowered once to series
+// operations whose coefficients follow the usual automatic differentiation
+// recurrences (products, quotients, exp, log, sin / cos pairs...), the
+// functions without one are built from an integral u' = a' g(a).
+// Order and step follow Jorba and Zou: the order is about half the number
+// of bits, the step makes the last two terms of the series smaller than
+// 2^-precision relative to the state, which keeps the step near the radius
+// of convergence divided by e^2.
+// Each step keeps its series when denseOutput is set, stateAt(t) then
+// evaluates the solution anywhere in the last integrated interval.
+// All work is done with guard bits, results are rounded to nearest.
+class TaylorIntegrator
+{
+public:
+	typedef Float::prec_t prec_t;
+	typedef void builder_pattern;
+	typedef int (*unary_t)(mpfr_ptr, mpfr_srcptr, mpfr_rnd_t);
+
+	enum Kind
+	{
+		Time,
+		State,
+		Constant,
+		Neg,
+		Add,
+		Sub,
+		Mul,
+		Div,
+		Exp,
+		Log,
+		Sin,
+		Cos,
+		Sinh,
+		Cosh,
+		Sqrt,
+		Power,
+		Integral,
+		Abs,
+		Step,
+		Min,
+		Max
+	};
+
+	// series operation, operands are node indices. Sin / Cos and Sinh / Cosh
+	// come in pairs, b being the partner. Integral is u' = a' g + c' h with
+	// g, h in b, d and u0 = start(a0) or start2(a0, c0). Step is start(a)
+	// with zero derivatives (floor, ceil, trunc)
+	struct Node
+	{
+		Kind kind;
+		int a = -1, b = -1, c = -1, d = -1;
+		unary_t start = nullptr;
+		Formula::binary_t start2 = nullptr;
+		Float value;
+		std::vector<Float> series;
+	};
+
+	struct Segment
+	{
+		Float t, h;
+		// component i, order k at i * (order + 1) + k
+		std::vector<Float> coefficients;
+	};
+
+private:
+	prec_t precision;
+	prec_t working;
+	size_t components;
+	int order = 0;
+	int maxSteps = 100000;
+	bool dense = true;
+	int steps = 0;
+	std::vector<Node> nodes;
+	std::vector<int> outputs;
+	std::vector<Segment> segments;
+	Float start, end;
+	std::string error;
+
+public:
+	// system is an array of Formulas, all over (t, y1 ... yn)
+	TaylorIntegrator(val system, prec_t precision);
+	TaylorIntegrator(const std::vector<const Formula *> &system, prec_t precision);
+
+	bool isValid() const;
+	std::string getError() const;
+	prec_t getPrecision() const;
+	int getOrder() const;
+	// 0 picks the order from the precision
+	builder_pattern setOrder(int order);
+	int getMaxSteps() const;
+	builder_pattern setMaxSteps(int n);
+	bool getDenseOutput() const;
+	builder_pattern setDenseOutput(bool dense);
+	int getSteps() const;
+
+	// y(t1) from y(t0) = y0, an array of Floats and numbers
+	FloatArray integrate(val t0, val y0, val t1);
+	// dense output within the last integrated interval
+	FloatArray stateAt(val t);
+	Float valueAt(val t, size_t component);
+
+	// native integration, false when it fails (see getError)
+	bool integrate(mpfr_srcptr t0, mpfr_srcptr const *y0, mpfr_srcptr t1, mpfr_ptr const *y1);
+	bool stateAt(mpfr_srcptr t, mpfr_ptr const *y);
+
+private:
+	static std::vector<const Formula *> formulas(val system);
+	int add(Kind kind, int a = -1, int b = -1);
+	int constant(double v);
+	int lower(const Formula &formula);
+	int call(const std::string &name, int a);
+	int call2(const std::string &name, int a, int b);
+	int integral(int a, int g, unary_t start);
+	int effectiveOrder() const;
+	void coefficient(Node &node, int k, Float &sum, Float &term);
+	// Taylor coefficients of the solution at t, y into segment
+	void expand(mpfr_srcptr t, const std::vector<Float> &y, int K, Segment &segment);
+	Float read(val v) const;
+};
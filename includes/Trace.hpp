@@ -0,0 +1,63 @@
+#pragma once
+
+#include <mpfr.h>
+#include <string>
+#include <vector>
+#include <emscripten.h>
+
+// Opt-in timeline of the op_* calls and the batch calls (Formula batches,
+// quadratures, Newton, series, ODE integration, sorts...), recorded into a
+// ring buffer that keeps the latest events, and exported as Chrome trace
+// event JSON for Perfetto or chrome://tracing.
+// A Span costs one test while tracing is off and two clock reads while it
+// is on; nested spans (the special functions of a Formula batch) show as
+// nested slices.
+class Trace
+{
+public:
+	typedef mpfr_prec_t prec_t;
+
+	struct Event
+	{
+		const char *name;
+		double begin;
+		double duration;
+		prec_t precision;
+	};
+
+	// times its scope, name must be a literal
+	class Span
+	{
+		const char *name;
+		prec_t precision;
+		double begin;
+
+	public:
+		Span(const char *name, prec_t precision)
+			: name(Trace::enabled ? name : nullptr), precision(precision), begin(Trace::enabled ? emscripten_get_now() : 0) {}
+		~Span()
+		{
+			if (name)
+				Trace::record(name, precision, begin, emscripten_get_now());
+		}
+	};
+
+	static bool enabled;
+
+	// clears the buffer and records up to capacity events, the oldest are
+	// overwritten beyond
+	static void start(size_t capacity);
+	static void stop();
+	static void clear();
+	static bool isEnabled();
+	static size_t getCount();
+	// events overwritten since start
+	static size_t getDropped();
+	// tid of the events, to tell workers apart when traces are merged
+	static int getThread();
+	static void setThread(int tid);
+	// {"traceEvents": [...]} oldest first, times in microseconds
+	static std::string toJSON();
+
+	static void record(const char *name, prec_t precision, double begin, double end);
+};
@@ -0,0 +1,40 @@
+// Appended to the generated glue with --post-js, runs inside the module scope.
+
+addOnPostRun(function () {
+	const Float = Module.Float;
+
+	// float.digits(base = 10, n = 0, chunk = 65536)
+	// iterator over Uint8Array chunks of ASCII text, same layout as toString()
+	Float.prototype.digits = function (base = 10, n = 0, chunk = 65536) {
+		const stream = new Module.DigitStream(this, base, n, chunk);
+		return (function* () {
+			try {
+				while (!stream.done())
+					yield stream.next().slice();
+			} finally {
+				stream.delete();
+			}
+		})();
+	};
+
+	// float.lazy(), records the following builder calls instead of running them
+	Float.prototype.lazy = function () {
+		return new Module.LazyFloat(this);
+	};
+
+	// for (const x of floatArray), yields copies that must be deleted
+	Module.FloatArray.prototype[Symbol.iterator] = function* () {
+		for (let i = 0; i < this.length; i++)
+			yield this.get(i);
+	};
+
+	// context.run(callback), callback() under the context, even if it throws
+	Module.Context.prototype.run = function (callback) {
+		this.enter();
+		try {
+			return callback();
+		} finally {
+			this.exit();
+		}
+	};
+});
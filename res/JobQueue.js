@@ -0,0 +1,183 @@
+// Runs Float methods on module instances hosted by workers, so a long
+// zeta() or gamma() does not block the calling thread. Operands travel as
+// Float.toBinary() images and results come back as new Floats.
+//
+// const queue = new JobQueue(Module, spawn, { workers: 2, maxQueued: 64 });
+// const y = await queue.submit('zeta', x, [], { signal }); // x is untouched
+// queue.install(Module.Float);                             // x.zetaAsync()
+//
+// spawn(onMessage, onError) starts a worker running JobWorker.js and returns
+// { postMessage(message, transfer), terminate() }, see NodeAPI.js / WebAPI.js.
+
+(function () {
+	// builder methods worth sending away, installed as <name>Async
+	const ASYNC_METHODS = [
+		'sqrt', 'cbrt', 'root_ui', 'pow', 'pow_si', 'log', 'log2', 'log10', 'log1p', 'exp', 'exp2', 'exp10', 'expm1',
+		'cos', 'sin', 'tan', 'acos', 'asin', 'atan', 'cosh', 'sinh', 'tanh', 'acosh', 'asinh', 'atanh',
+		'eint', 'li2', 'gamma', 'gamma_inc', 'lngamma', 'digamma', 'beta', 'zeta', 'zeta_ui', 'erf', 'erfc',
+		'j0', 'j1', 'jn', 'y0', 'y1', 'yn', 'agm', 'ai', 'const_log2', 'const_pi', 'const_euler', 'const_catalan'
+	];
+
+	function abortError() {
+		const error = new Error('job cancelled');
+		error.name = 'AbortError';
+		return error;
+	}
+
+	class JobQueue {
+		constructor(Module, spawn, { workers = 1, maxQueued = 64 } = {}) {
+			this.Module = Module;
+			this.spawn = spawn;
+			this.maxQueued = maxQueued;
+			this.queued = [];
+			this.nextId = 1;
+			this.slots = [];
+			for (let i = 0; i < workers; i++)
+				this.slots.push(this.start({ worker: null, job: null }));
+		}
+
+		// jobs waiting for a worker
+		get pending() {
+			return this.queued.length;
+		}
+
+		// submit(method, target, args = [], { signal }), resolves to a new Float
+		// holding target[method](...args). Floats in args are copied at once,
+		// so the caller may change or delete them right after.
+		submit(method, target, args = [], { signal } = {}) {
+			if (signal && signal.aborted)
+				return Promise.reject(abortError());
+			if (this.queued.length >= this.maxQueued)
+				return Promise.reject(new Error('job queue is full'));
+			return new Promise((resolve, reject) => {
+				const job = {
+					id: this.nextId++,
+					message: null,
+					transfer: [],
+					resolve,
+					reject,
+					signal,
+					onAbort: null
+				};
+				job.message = {
+					id: job.id,
+					method,
+					target: this.encode(target, job.transfer),
+					args: args.map(arg => this.encode(arg, job.transfer))
+				};
+				if (signal) {
+					job.onAbort = () => this.cancel(job);
+					signal.addEventListener('abort', job.onAbort);
+				}
+				this.queued.push(job);
+				this.dispatch();
+			});
+		}
+
+		// rejects every job still waiting, running ones finish
+		cancelAll() {
+			for (const job of this.queued.splice(0))
+				this.settle(job, null, abortError());
+		}
+
+		terminate() {
+			this.cancelAll();
+			for (const slot of this.slots) {
+				if (slot.job)
+					this.settle(slot.job, null, abortError());
+				slot.worker.terminate();
+			}
+			this.slots = [];
+		}
+
+		// Float.prototype.<name>Async(...args) for the given builder methods
+		install(Float, methods = ASYNC_METHODS) {
+			const queue = this;
+			for (const name of methods)
+				Float.prototype[name + 'Async'] = function (...args) {
+					return queue.submit(name, this, args);
+				};
+		}
+
+		encode(value, transfer) {
+			if (value instanceof this.Module.Float) {
+				const binary = value.toBinary();
+				transfer.push(binary.buffer);
+				return { binary };
+			}
+			return value;
+		}
+
+		start(slot) {
+			slot.worker = this.spawn(
+				message => this.finish(slot, message),
+				error => this.crash(slot, error)
+			);
+			return slot;
+		}
+
+		dispatch() {
+			for (const slot of this.slots) {
+				if (slot.job || !this.queued.length)
+					continue;
+				slot.job = this.queued.shift();
+				slot.worker.postMessage(slot.job.message, slot.job.transfer);
+			}
+		}
+
+		cancel(job) {
+			const index = this.queued.indexOf(job);
+			if (index >= 0)
+				this.queued.splice(index, 1);
+			else {
+				// a running job can only be stopped with its worker
+				const slot = this.slots.find(slot => slot.job === job);
+				if (!slot)
+					return;
+				slot.worker.terminate();
+				slot.job = null;
+				this.start(slot);
+			}
+			this.settle(job, null, abortError());
+			this.dispatch();
+		}
+
+		finish(slot, { id, result, error }) {
+			const job = slot.job;
+			if (!job || job.id !== id)
+				return;
+			slot.job = null;
+			if (error !== undefined)
+				this.settle(job, null, new Error(error));
+			else
+				this.settle(job, this.Module.Float.fromBinary(result), null);
+			this.dispatch();
+		}
+
+		crash(slot, error) {
+			const job = slot.job;
+			slot.worker.terminate();
+			slot.job = null;
+			this.start(slot);
+			if (job)
+				this.settle(job, null, error instanceof Error ? error : new Error(String(error)));
+			this.dispatch();
+		}
+
+		settle(job, value, error) {
+			if (job.signal)
+				job.signal.removeEventListener('abort', job.onAbort);
+			if (error)
+				job.reject(error);
+			else
+				job.resolve(value);
+		}
+	}
+
+	JobQueue.ASYNC_METHODS = ASYNC_METHODS;
+
+	if (typeof module !== 'undefined' && module.exports)
+		module.exports = JobQueue;
+	else
+		globalThis.GnuMPJobQueue = JobQueue;
+})();
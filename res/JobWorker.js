@@ -0,0 +1,55 @@
+// Worker side of JobQueue.js: hosts its own module instance and answers
+// { id, method, target, args } with { id, result } or { id, error }.
+
+const node = typeof process !== 'undefined' && process.versions && process.versions.node;
+const port = node ? require('worker_threads').parentPort : self;
+
+// instantiates from the module compiled by the page or main thread when
+// given, the listener is attached right away and messages wait here
+let ready = null;
+function load(wasmModule) {
+	if (node) {
+		const options = wasmModule ? require('./Loader.js').options(wasmModule) : {};
+		return require('./gnu-mp.js')(options);
+	}
+	return Promise.all([import('./gnu-mp.js'), wasmModule && import('./Loader.js')])
+		.then(([glue]) => glue.default(wasmModule ? globalThis.GnuMPLoader.options(wasmModule) : {}));
+}
+if (node)
+	ready = load(require('worker_threads').workerData?.wasmModule);
+
+async function run({ id, method, target, args }) {
+	const Float = (await (ready = ready || load())).Float;
+	const owned = [];
+	const decode = value => {
+		if (!value || !value.binary)
+			return value;
+		const float = Float.fromBinary(value.binary);
+		owned.push(float);
+		return float;
+	};
+	try {
+		if (typeof Float.prototype[method] !== 'function')
+			throw new Error('unknown Float method ' + method);
+		const x = decode({ binary: target });
+		x[method](...args.map(decode));
+		const result = x.toBinary();
+		port.postMessage({ id, result }, [result.buffer]);
+	} catch (error) {
+		port.postMessage({ id, error: String(error && error.message || error) });
+	} finally {
+		for (const float of owned)
+			float.delete();
+		Float.free_cache();
+	}
+}
+
+if (node)
+	port.on('message', run);
+else
+	port.onmessage = event => {
+		if (event.data.wasmModule)
+			ready = load(event.data.wasmModule);
+		else
+			run(event.data);
+	};
@@ -0,0 +1,50 @@
+// Compiles gnu-mp.wasm once and instantiates the glue from the compiled
+// WebAssembly.Module, which can be posted to workers so they skip the
+// compilation. Shared by NodeAPI.js, WebAPI.js and JobWorker.js.
+//
+// const wasmModule = await Loader.compile(source);   // once per process
+// const Module = await factory(Loader.options(wasmModule));
+
+(function () {
+	let compiled = null;
+
+	const Loader = {
+		// source: WebAssembly.Module, bytes, a Response or a promise of one
+		// (compiled while it downloads), cached for the next calls
+		compile(source) {
+			if (!compiled) {
+				compiled = Loader.compileFrom(source);
+				compiled.catch(() => compiled = null);
+			}
+			return compiled;
+		},
+
+		async compileFrom(source) {
+			source = await source;
+			if (source instanceof WebAssembly.Module)
+				return source;
+			if (typeof Response !== 'undefined' && source instanceof Response) {
+				// streaming needs the application/wasm MIME type
+				if (WebAssembly.compileStreaming && (source.headers.get('Content-Type') || '').startsWith('application/wasm'))
+					return WebAssembly.compileStreaming(source);
+				source = await source.arrayBuffer();
+			}
+			return WebAssembly.compile(source);
+		},
+
+		// factory options instantiating from the compiled module
+		options(wasmModule, extra = {}) {
+			return Object.assign({}, extra, {
+				instantiateWasm(imports, receive) {
+					WebAssembly.instantiate(wasmModule, imports).then(instance => receive(instance, wasmModule));
+					return {};
+				}
+			});
+		}
+	};
+
+	if (typeof module !== 'undefined' && module.exports)
+		module.exports = Loader;
+	else
+		globalThis.GnuMPLoader = Loader;
+})();
@@ -1,8 +1,22 @@
+const { Readable } = require('stream');
+const { Worker } = require('worker_threads');
+const path = require('path');
+const fs = require('fs');
+const JobQueue = require('./JobQueue.js');
+const Loader = require('./Loader.js');
 
+// compiled once per process, pass it as { wasmModule } to the loader of
+// another worker to skip the compilation there
+function compile() {
+	return Loader.compile(fs.promises.readFile(path.join(__dirname, 'gnu-mp.wasm')));
+}
 
+// last write of each checkpoint, so records reach the file in order
+const checkpointWrites = new WeakMap();
 
-module.exports = async function () {
-	const Module = await require('./gnu-mp.js')();
+module.exports = async function ({ wasmModule } = {}) {
+	wasmModule = wasmModule || await compile();
+	const Module = await require('./gnu-mp.js')(Loader.options(wasmModule));
 	return {
 		Module,
 		Float: Module.Float,
@@ -14,6 +28,9 @@ module.exports = async function () {
 			AwayZero: Module.AwayZero,
 			Faithful: Module.Faithful
 		},
+		streamDigits(float, base = 10, n = 0, chunk = 65536) {
+			return Readable.from(float.digits(base, n, chunk));
+		},
 		RAII(callback) {
 			const registers = [];
 			function makeRegister(...args) {
@@ -25,6 +42,74 @@ module.exports = async function () {
 			for (const register of registers)
 				register.delete();
 			Module.Float.free_cache()
+		},
+		// constant store kept across processes, a missing file loads nothing
+		loadConstants(file) {
+			if (!fs.existsSync(file))
+				return 0;
+			return Module.Constants.load(fs.readFileSync(file));
+		},
+		saveConstants(file) {
+			// written aside then renamed, so a crash never leaves half a file
+			fs.writeFileSync(file + '.tmp', Module.Constants.save());
+			fs.renameSync(file + '.tmp', file);
+		},
+		// checkpoint read from file, empty when there is none yet. A torn or
+		// corrupted record at the end is cut off, so the next delta follows
+		// the last valid record instead of the garbage
+		loadCheckpoint(file) {
+			const checkpoint = new Module.Checkpoint();
+			if (fs.existsSync(file)) {
+				const bytes = fs.readFileSync(file);
+				checkpoint.load(bytes);
+				if (checkpoint.loadedSize < bytes.length)
+					fs.truncateSync(file, checkpoint.loadedSize);
+			}
+			return checkpoint;
+		},
+		// the record is taken at once, the computation can go on while it is
+		// written; a delta is appended, a full record replaces the file.
+		// A failed write breaks the sequence: the checkpoint stays broken,
+		// deltas queued behind it are dropped (their promise rejects) and the
+		// next record is full, until one is written
+		writeCheckpoint(checkpoint, file, { full = false } = {}) {
+			let writes = checkpointWrites.get(checkpoint);
+			if (!writes)
+				checkpointWrites.set(checkpoint, writes = { done: Promise.resolve(), broken: false });
+			full = full || writes.broken || !fs.existsSync(file);
+			const record = checkpoint.save(full);
+			writes.done = writes.done.catch(() => {}).then(() => {
+				if (!full && writes.broken)
+					throw new Error('checkpoint delta dropped after a failed write');
+				return full
+					? fs.promises.writeFile(file + '.tmp', record).then(() => fs.promises.rename(file + '.tmp', file))
+					: fs.promises.appendFile(file, record);
+			}).then(() => {
+				if (full)
+					writes.broken = false;
+			}, error => {
+				writes.broken = true;
+				throw error;
+			});
+			return writes.done;
+		},
+		// Chrome trace event file of Module.Trace, open it in Perfetto
+		writeTrace(file) {
+			fs.writeFileSync(file, Module.Trace.toJSON());
+		},
+		// worker pool for the <name>Async() Float methods, keeps the process
+		// alive until queue.terminate()
+		createJobQueue(options) {
+			const queue = new JobQueue(Module, (onMessage, onError) => {
+				const worker = new Worker(path.join(__dirname, 'JobWorker.js'), { workerData: { wasmModule } });
+				worker.on('message', onMessage);
+				worker.on('error', onError);
+				return worker;
+			}, options);
+			queue.install(Module.Float);
+			return queue;
 		}
 	}
-};
\ No newline at end of file
+};
+
+module.exports.compile = compile;
\ No newline at end of file
@@ -1,8 +1,16 @@
 
 
 
-window.loadGnuMP = async function () {
-	const Module = await (await import('./gnu-mp.js')).default();
+// workers are loaded next to this script
+const gnuMPBase = document.currentScript ? document.currentScript.src : location.href;
+
+// wasmModule: a WebAssembly.Module compiled earlier, by default the wasm is
+// compiled while it downloads and kept for the next calls and the workers
+window.loadGnuMP = async function ({ wasmModule } = {}) {
+	const [glue] = await Promise.all([import('./gnu-mp.js'), import('./Loader.js'), import('./JobQueue.js')]);
+	const Loader = globalThis.GnuMPLoader, JobQueue = globalThis.GnuMPJobQueue;
+	wasmModule = wasmModule || await Loader.compile(fetch(new URL('gnu-mp.wasm', gnuMPBase)));
+	const Module = await glue.default(Loader.options(wasmModule));
 	return {
 		Module,
 		Float: Module.Float,
@@ -14,6 +22,21 @@ window.loadGnuMP = async function () {
 			AwayZero: Module.AwayZero,
 			Faithful: Module.Faithful
 		},
+		streamDigits(float, base = 10, n = 0, chunk = 65536) {
+			const chunks = float.digits(base, n, chunk);
+			return new ReadableStream({
+				pull(controller) {
+					const { value, done } = chunks.next();
+					if (done)
+						controller.close();
+					else
+						controller.enqueue(value);
+				},
+				cancel() {
+					chunks.return();
+				}
+			});
+		},
 		RAII(callback) {
 			const registers = [];
 			function makeRegister(...args) {
@@ -25,6 +48,18 @@ window.loadGnuMP = async function () {
 			for (const register of registers)
 				register.delete();
 			Module.Float.free_cache()
+		},
+		// worker pool for the <name>Async() Float methods
+		createJobQueue(options) {
+			const queue = new JobQueue(Module, (onMessage, onError) => {
+				const worker = new Worker(new URL('JobWorker.js', gnuMPBase));
+				worker.postMessage({ wasmModule });
+				worker.onmessage = event => onMessage(event.data);
+				worker.onerror = event => onError(new Error(event.message));
+				return worker;
+			}, options);
+			queue.install(Module.Float);
+			return queue;
 		}
 	}
 };
\ No newline at end of file
@@ -9,7 +9,7 @@ const src = `if (returns) {
                            "return ret;\\n";
       }`;
 
-const patch = src + ` else if(classType && ['Float'].includes(classType.name)) {
+const patch = src + ` else if(classType && ['Float', 'LazyFloat', 'Accumulator', 'FloatArray', 'Formula', 'Quadrature', 'RootFinder', 'Context', 'FloatSet', 'FloatMap', 'PrecisionAnalyzer', 'Checkpoint', 'Dual', 'TaylorIntegrator', 'Statistics', 'IntegerRelation', 'Convolution'].includes(classType.name)) {
 		invokerFnBody += "return this;\\n";
 	}`;
 
@@ -0,0 +1,389 @@
+#include <mpfr.h>
+#include <gmp.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+#include "Accumulator.hpp"
+#include "Trace.hpp"
+
+// Fixed-point accumulator for batches of doubles: 32-bit digits in int64
+// slots, digit i weighs 2^(BASE + 32 i). BASE is below the smallest product
+// of two subnormals and the top digits leave room for the carries, so every
+// finite double and product of doubles is added exactly without propagating
+// carries, which is done every NORMALIZE terms and before flushing.
+struct Digits
+{
+	static const int BASE = -2176;
+	static const int COUNT = 136;
+	static const size_t NORMALIZE = 1 << 20;
+
+	int64_t d[COUNT] = {};
+
+	// adds m * 2^e, BASE <= e
+	void add(uint64_t m, int e, bool negative)
+	{
+		int offset = e - BASE, i = offset >> 5, sh = offset & 31;
+		uint64_t lo = (m & 0xffffffff) << sh, hi = (m >> 32) << sh;
+		int64_t d0 = (uint32_t)lo, d1 = (lo >> 32) + (uint32_t)hi, d2 = hi >> 32;
+		if (negative)
+		{
+			d[i] -= d0;
+			d[i + 1] -= d1;
+			d[i + 2] -= d2;
+		}
+		else
+		{
+			d[i] += d0;
+			d[i + 1] += d1;
+			d[i + 2] += d2;
+		}
+	}
+
+	// digits below the top one in [0, 2^32)
+	void normalize()
+	{
+		for (int i = 0; i < COUNT - 1; i++)
+		{
+			int64_t carry = d[i] >> 32;
+			d[i] -= carry * ((int64_t)1 << 32);
+			d[i + 1] += carry;
+		}
+	}
+
+	// value as m * 2^BASE
+	bool get(mpz_ptr m)
+	{
+		normalize();
+		uint32_t digits[COUNT - 1];
+		bool zero = d[COUNT - 1] == 0;
+		for (int i = 0; i < COUNT - 1; i++)
+		{
+			digits[i] = (uint32_t)d[i];
+			zero &= digits[i] == 0;
+		}
+		if (zero)
+			return false;
+		mpz_import(m, COUNT - 1, -1, sizeof(uint32_t), 0, 0, digits);
+		mpz_t top;
+		mpz_init_set_si(top, (long)d[COUNT - 1]);
+		mpz_mul_2exp(top, top, 32 * (COUNT - 1));
+		mpz_add(m, m, top);
+		mpz_clear(top);
+		return true;
+	}
+};
+
+// finite nonzero x = m * 2^e with m < 2^53
+static void split(double x, uint64_t &m, int &e)
+{
+	uint64_t bits;
+	std::memcpy(&bits, &x, sizeof bits);
+	int biased = (bits >> 52) & 0x7ff;
+	m = bits & (((uint64_t)1 << 52) - 1);
+	if (biased)
+	{
+		m |= (uint64_t)1 << 52;
+		e = biased - 1075;
+	}
+	else
+		e = -1074;
+}
+
+Accumulator::Accumulator(prec_t precision) : precision(precision)
+{
+	mpz_init(&sum);
+	mpz_init(&term);
+}
+
+Accumulator::~Accumulator()
+{
+	mpz_clear(&sum);
+	mpz_clear(&term);
+}
+
+Accumulator::prec_t Accumulator::getPrecision() const { return precision; }
+Accumulator::builder_pattern Accumulator::setPrecision(prec_t precision) { this->precision = precision; }
+
+Accumulator::builder_pattern Accumulator::reset()
+{
+	mpz_set_ui(&sum, 0);
+	scale = 0;
+	nan = positiveInf = negativeInf = nonzero = positiveZero = negativeZero = false;
+}
+
+Accumulator::builder_pattern Accumulator::add(val v)
+{
+	if (v.isNumber())
+		addDouble(v.as<double>());
+	else
+		addFloat(v.as<const Float &>().ptr(), false);
+}
+
+Accumulator::builder_pattern Accumulator::sub(val v)
+{
+	if (v.isNumber())
+		addDouble(-v.as<double>());
+	else
+		addFloat(v.as<const Float &>().ptr(), true);
+}
+
+// Float64Array, or array of Floats and numbers
+Accumulator::builder_pattern Accumulator::addAll(val array)
+{
+	Trace::Span span("Accumulator.addAll", precision);
+	int length = array["length"].as<int>();
+	if (isFloat64Array(array))
+	{
+		std::vector<double> copy;
+		addDoubles(doubles(array, copy), length);
+		return;
+	}
+	for (int i = 0; i < length; i++)
+		add(array[i]);
+}
+
+// adds the dot product of two Float64Arrays, or arrays of Floats and numbers
+Accumulator::builder_pattern Accumulator::addDot(val a, val b)
+{
+	Trace::Span span("Accumulator.addDot", precision);
+	int length = a["length"].as<int>();
+	if (length != b["length"].as<int>())
+	{
+		std::cerr << "error: dot product of array of different size" << std::endl;
+		return;
+	}
+	if (isFloat64Array(a) && isFloat64Array(b))
+	{
+		std::vector<double> copyA, copyB;
+		addProducts(doubles(a, copyA), doubles(b, copyB), length);
+		return;
+	}
+	for (int i = 0; i < length; i++)
+	{
+		Float u(53), v(53);
+		const Float &x = a[i].isNumber() ? (u = a[i].as<double>()) : a[i].as<const Float &>();
+		const Float &y = b[i].isNumber() ? (v = b[i].as<double>()) : b[i].as<const Float &>();
+		Float product(x.getPrecision() + y.getPrecision());
+		mpfr_mul(product.ptr(), x.ptr(), y.ptr(), MPFR_RNDN);
+		addFloat(product.ptr(), false);
+	}
+}
+
+Float Accumulator::result(int rounding)
+{
+	Float out(precision);
+	round(out.ptr(), (mpfr_rnd_t)rounding);
+	return out;
+}
+
+int Accumulator::round(mpfr_ptr r, mpfr_rnd_t rounding) const
+{
+	if (nan || (positiveInf && negativeInf))
+	{
+		mpfr_set_nan(r);
+		return 0;
+	}
+	if (positiveInf || negativeInf)
+	{
+		mpfr_set_inf(r, positiveInf ? 1 : -1);
+		return 0;
+	}
+	if (mpz_sgn(&sum) == 0)
+	{
+		// same sign rules as mpfr_sum: -0 for a sum of -0 only, or for mixed
+		// zeros and exact cancellations rounded toward -inf
+		bool negative = rounding == MPFR_RNDD ? nonzero || negativeZero : negativeZero && !positiveZero && !nonzero;
+		mpfr_set_zero(r, negative ? -1 : 1);
+		return 0;
+	}
+	return mpfr_set_z_2exp(r, &sum, scale, rounding);
+}
+
+bool Accumulator::exact(mpz_ptr m, exp_t &e) const
+{
+	if (nan || positiveInf || negativeInf)
+		return false;
+	mpz_set(m, &sum);
+	e = scale;
+	return true;
+}
+
+void Accumulator::addFloat(mpfr_srcptr x, bool negate)
+{
+	if (special(x, negate))
+		return;
+
+	// x = 0.d * 2^exp, skipping the zero low limbs of the significand
+	mp_size_t n = (mpfr_get_prec(x) - 1) / GMP_NUMB_BITS + 1;
+	mp_srcptr d = x->_mpfr_d;
+	while (!d[0])
+	{
+		d++;
+		n--;
+	}
+	exp_t e = mpfr_get_exp(x) - (exp_t)n * GMP_NUMB_BITS;
+	__mpz_struct m;
+	addTerm(mpz_roinit_n(&m, d, (mpfr_signbit(x) != negate) ? -n : n), e);
+}
+
+void Accumulator::addDouble(double x)
+{
+	if (std::isnan(x))
+		nan = true;
+	else if (std::isinf(x))
+		(x > 0 ? positiveInf : negativeInf) = true;
+	else if (x == 0)
+		(std::signbit(x) ? negativeZero : positiveZero) = true;
+	else
+	{
+		int e;
+		double f = std::frexp(x, &e);
+		nonzero = true;
+		mpz_set_d(&term, std::ldexp(f, 53));
+		addTerm(&term, e - 53);
+	}
+}
+
+void Accumulator::addDoubles(const double *x, size_t n)
+{
+	Digits digits;
+	for (size_t i = 0; i < n; i++)
+	{
+		if (!std::isfinite(x[i]) || x[i] == 0)
+		{
+			addDouble(x[i]);
+			continue;
+		}
+		uint64_t m;
+		int e;
+		split(x[i], m, e);
+		digits.add(m, e, std::signbit(x[i]));
+		nonzero = true;
+		if ((i + 1) % Digits::NORMALIZE == 0)
+			digits.normalize();
+	}
+	if (digits.get(&term))
+		addTerm(&term, Digits::BASE);
+}
+
+// products are exact: the 106-bit product of the significands goes in as
+// its 32x32-bit partial products (the high halves are 21 bits, the middle
+// terms sum without overflow)
+void Accumulator::addProducts(const double *a, const double *b, size_t n)
+{
+	Digits digits;
+	for (size_t i = 0; i < n; i++)
+	{
+		if (!std::isfinite(a[i]) || !std::isfinite(b[i]) || a[i] == 0 || b[i] == 0)
+		{
+			// NaN, infinities and signed zeros as IEEE gives them
+			addDouble(a[i] * b[i]);
+			continue;
+		}
+		uint64_t ma, mb;
+		int ea, eb;
+		split(a[i], ma, ea);
+		split(b[i], mb, eb);
+		bool negative = std::signbit(a[i]) != std::signbit(b[i]);
+		uint64_t a0 = ma & 0xffffffff, a1 = ma >> 32, b0 = mb & 0xffffffff, b1 = mb >> 32;
+		int e = ea + eb;
+		digits.add(a0 * b0, e, negative);
+		digits.add(a0 * b1 + a1 * b0, e + 32, negative);
+		digits.add(a1 * b1, e + 64, negative);
+		nonzero = true;
+		if ((i + 1) % Digits::NORMALIZE == 0)
+			digits.normalize();
+	}
+	if (digits.get(&term))
+		addTerm(&term, Digits::BASE);
+}
+
+bool Accumulator::isFloat64Array(val v)
+{
+	return v.instanceof(val::global("Float64Array"));
+}
+
+const double *Accumulator::doubles(val array, std::vector<double> &copy)
+{
+	size_t length = array["length"].as<size_t>();
+	val memory = val(typed_memory_view(0, (const double *)nullptr))["buffer"];
+	if (array["buffer"].strictlyEquals(memory))
+		return (const double *)array["byteOffset"].as<uintptr_t>();
+	copy.resize(length);
+	val(typed_memory_view(length, copy.data())).call<void>("set", array);
+	return copy.data();
+}
+
+bool Accumulator::special(mpfr_srcptr x, bool negate)
+{
+	bool negative = mpfr_signbit(x) != negate;
+	if (mpfr_nan_p(x))
+		nan = true;
+	else if (mpfr_inf_p(x))
+		(negative ? negativeInf : positiveInf) = true;
+	else if (mpfr_zero_p(x))
+		(negative ? negativeZero : positiveZero) = true;
+	else
+	{
+		nonzero = true;
+		return false;
+	}
+	return true;
+}
+
+// out = x / 2^shift rounded to odd one bit below: the bits shifted out are
+// ORed into a sticky last bit, floor(x / 2^shift) 2 + 1 when any is set
+static void sticky(mpz_ptr out, mpz_srcptr x, Accumulator::exp_t shift)
+{
+	bool inexact = !mpz_divisible_2exp_p(x, shift);
+	mpz_fdiv_q_2exp(out, x, shift);
+	mpz_mul_2exp(out, out, 1);
+	if (inexact)
+		mpz_add_ui(out, out, 1);
+}
+
+// sum * 2^scale += m * 2^e, m may alias term; bits below
+// top - (precision + WIDTH) go to a sticky bit so the integer stays bounded
+void Accumulator::addTerm(mpz_srcptr m, exp_t e)
+{
+	if (mpz_sgn(m) == 0)
+		return;
+	exp_t top = e + (exp_t)mpz_sizeinbase(m, 2);
+	if (mpz_sgn(&sum) != 0)
+		top = std::max(top, scale + (exp_t)mpz_sizeinbase(&sum, 2));
+	exp_t cut = top - (exp_t)precision - WIDTH;
+	if (e < cut)
+	{
+		sticky(&term, m, cut - e);
+		m = &term;
+		e = cut - 1;
+	}
+	if (mpz_sgn(&sum) == 0)
+	{
+		mpz_set(&sum, m);
+		scale = e;
+		return;
+	}
+	if (scale < cut)
+	{
+		sticky(&sum, &sum, cut - scale);
+		scale = cut - 1;
+	}
+	if (e >= scale)
+	{
+		mpz_mul_2exp(&term, m, e - scale);
+		mpz_add(&sum, &sum, &term);
+	}
+	else
+	{
+		mpz_mul_2exp(&sum, &sum, scale - e);
+		scale = e;
+		mpz_add(&sum, &sum, m);
+	}
+}
@@ -0,0 +1,226 @@
+#include <mpfr.h>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+#include "Checkpoint.hpp"
+
+static const uint8_t MAGIC[] = {'G', 'M', 'P', 'K', 1};
+static const size_t HEADER = sizeof(MAGIC) + 1 + 4 + 4;
+enum Kind : uint8_t
+{
+	Full,
+	Delta
+};
+
+static void put32(std::vector<uint8_t> &out, uint32_t v)
+{
+	for (int i = 0; i < 4; i++)
+		out.push_back(v >> (8 * i));
+}
+
+static uint32_t get32(const uint8_t *data)
+{
+	return data[0] | data[1] << 8 | data[2] << 16 | (uint32_t)data[3] << 24;
+}
+
+static void set32(uint8_t *data, uint32_t v)
+{
+	for (int i = 0; i < 4; i++)
+		data[i] = v >> (8 * i);
+}
+
+// FNV-1a
+static uint32_t checksum(const uint8_t *data, size_t size)
+{
+	uint32_t h = 2166136261u;
+	for (size_t i = 0; i < size; i++)
+		h = (h ^ data[i]) * 16777619u;
+	return h;
+}
+
+Checkpoint::Checkpoint() {}
+
+Checkpoint::builder_pattern Checkpoint::set(const std::string &name, const Float &value)
+{
+	auto it = values.find(name);
+	if (it == values.end())
+		values.emplace(name, value);
+	else
+	{
+		mpfr_set_prec(it->second.ptr(), value.getPrecision());
+		mpfr_set(it->second.ptr(), value.ptr(), MPFR_RNDN);
+	}
+	changed.insert(name);
+}
+
+bool Checkpoint::get(const std::string &name, Float &out) const
+{
+	auto it = values.find(name);
+	if (it == values.end())
+		return false;
+	mpfr_set(out.ptr(), it->second.ptr(), (mpfr_rnd_t)out.getRounding());
+	return true;
+}
+
+bool Checkpoint::has(const std::string &name) const { return values.count(name); }
+
+bool Checkpoint::remove(const std::string &name)
+{
+	if (!values.erase(name))
+		return false;
+	changed.insert(name);
+	return true;
+}
+
+val Checkpoint::names() const
+{
+	val out = val::array();
+	for (const auto &entry : values)
+		out.call<void>("push", entry.first);
+	return out;
+}
+
+std::string Checkpoint::getState() const { return state; }
+Checkpoint::builder_pattern Checkpoint::setState(const std::string &state) { this->state = state; }
+uint32_t Checkpoint::getGeneration() const { return generation; }
+
+size_t Checkpoint::getPendingSize() const
+{
+	size_t size = HEADER + 4 + 4 + state.size() + 4;
+	for (const std::string &name : changed)
+	{
+		auto it = values.find(name);
+		size += 4 + name.size() + 1 + (it == values.end() ? 0 : 20 + (it->second.getPrecision() + 7) / 8);
+	}
+	return size;
+}
+
+void Checkpoint::writeEntry(std::vector<uint8_t> &out, const std::string &name) const
+{
+	put32(out, name.size());
+	out.insert(out.end(), name.begin(), name.end());
+	auto it = values.find(name);
+	out.push_back(it != values.end());
+	if (it != values.end())
+		it->second.writeBinary(out);
+}
+
+// the first record of a checkpoint is always full
+void Checkpoint::writeRecord(std::vector<uint8_t> &out, bool full)
+{
+	full = full || !generation;
+	size_t start = out.size();
+	out.insert(out.end(), MAGIC, MAGIC + sizeof(MAGIC));
+	out.push_back(full ? Full : Delta);
+	put32(out, ++generation);
+	put32(out, 0);
+	size_t body = out.size();
+	put32(out, state.size());
+	out.insert(out.end(), state.begin(), state.end());
+	put32(out, full ? values.size() : changed.size());
+	if (full)
+		for (const auto &entry : values)
+			writeEntry(out, entry.first);
+	else
+		for (const std::string &name : changed)
+			writeEntry(out, name);
+	set32(&out[start + HEADER - 4], out.size() - body);
+	put32(out, checksum(&out[start], out.size() - start));
+	changed.clear();
+}
+
+// 0 when the record is invalid, nothing is applied then
+size_t Checkpoint::readRecord(const uint8_t *data, size_t size)
+{
+	if (size < HEADER + 4 || std::memcmp(data, MAGIC, sizeof(MAGIC)) || data[sizeof(MAGIC)] > Delta)
+		return 0;
+	bool full = data[sizeof(MAGIC)] == Full;
+	uint32_t number = get32(data + sizeof(MAGIC) + 1), length = get32(data + HEADER - 4);
+	if (length > size - HEADER - 4 || get32(data + HEADER + length) != checksum(data, HEADER + length))
+		return 0;
+	if (!full && number != generation + 1)
+		return 0;
+
+	const uint8_t *at = data + HEADER, *end = at + length;
+	auto string = [&](std::string &out) {
+		if (end - at < 4 || (size_t)(end - at - 4) < get32(at))
+			return false;
+		out.assign(at + 4, at + 4 + get32(at));
+		at += 4 + out.size();
+		return true;
+	};
+	std::string nextState;
+	if (!string(nextState) || end - at < 4)
+		return 0;
+	uint32_t count = get32(at);
+	at += 4;
+	std::map<std::string, Float> entries;
+	std::set<std::string> removed;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		std::string name;
+		if (!string(name) || at == end)
+			return 0;
+		if (!*at++)
+		{
+			removed.insert(name);
+			continue;
+		}
+		Float value(MPFR_PREC_MIN);
+		size_t read = value.readBinary(at, end - at);
+		if (!read)
+			return 0;
+		at += read;
+		entries.erase(name);
+		entries.emplace(name, value);
+	}
+	if (at != end)
+		return 0;
+
+	if (full)
+		values.clear();
+	for (const std::string &name : removed)
+		values.erase(name);
+	for (auto &entry : entries)
+	{
+		values.erase(entry.first);
+		values.emplace(entry.first, entry.second);
+	}
+	state.swap(nextState);
+	generation = number;
+	changed.clear();
+	return HEADER + length + 4;
+}
+
+val Checkpoint::save(bool full)
+{
+	std::vector<uint8_t> out;
+	writeRecord(out, full);
+	return val::global("Uint8Array").new_(typed_memory_view(out.size(), out.data()));
+}
+
+int Checkpoint::load(val bytes)
+{
+	val view = val::global("Uint8Array").new_(bytes);
+	std::vector<uint8_t> data(view["length"].as<size_t>());
+	val(typed_memory_view(data.size(), data.data())).call<void>("set", view);
+	int count = 0;
+	for (loadedSize = 0; loadedSize < data.size(); count++)
+	{
+		size_t read = readRecord(&data[loadedSize], data.size() - loadedSize);
+		if (!read)
+		{
+			std::cerr << "error: checkpoint truncated or corrupted after " << count << " records" << std::endl;
+			break;
+		}
+		loadedSize += read;
+	}
+	return count;
+}
+
+size_t Checkpoint::getLoadedSize() const { return loadedSize; }
@@ -0,0 +1,179 @@
+#include <mpfr.h>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+#include "Constants.hpp"
+
+// bits computed past the request, so nearby precisions hit the store
+static const Constants::prec_t GUARD = 32;
+
+static int exp1(mpfr_ptr out, mpfr_rnd_t rnd)
+{
+	mpfr_t one;
+	mpfr_init2(one, MPFR_PREC_MIN);
+	mpfr_set_ui(one, 1, MPFR_RNDN);
+	int ternary = mpfr_exp(out, one, rnd);
+	mpfr_clear(one);
+	return ternary;
+}
+
+static const struct
+{
+	const char *name;
+	int (*compute)(mpfr_ptr, mpfr_rnd_t);
+} known[] = {
+	{"pi", mpfr_const_pi},
+	{"log2", mpfr_const_log2},
+	{"euler", mpfr_const_euler},
+	{"catalan", mpfr_const_catalan},
+	{"e", exp1},
+};
+
+std::map<std::string, Float> &Constants::store()
+{
+	static std::map<std::string, Float> values;
+	return values;
+}
+
+bool Constants::round(const Float &stored, mpfr_ptr out, mpfr_rnd_t rnd, int &ternary)
+{
+	prec_t p = mpfr_get_prec(out);
+	if (!mpfr_regular_p(stored.ptr()))
+	{
+		ternary = mpfr_set(out, stored.ptr(), rnd);
+		return true;
+	}
+	// RNDZ at one more bit also settles the ternary value (MPFR manual)
+	if (stored.getPrecision() <= (size_t)p || !mpfr_can_round(stored.ptr(), stored.getPrecision(), MPFR_RNDN, MPFR_RNDZ, p + (rnd == MPFR_RNDN)))
+		return false;
+	ternary = mpfr_set(out, stored.ptr(), rnd);
+	return true;
+}
+
+int Constants::evaluate(const std::string &name, mpfr_ptr out, mpfr_rnd_t rnd)
+{
+	std::map<std::string, Float> &values = store();
+	int ternary;
+	auto it = values.find(name);
+	if (it != values.end() && round(it->second, out, rnd, ternary))
+		return ternary;
+	for (const auto &constant : known)
+	{
+		if (name != constant.name)
+			continue;
+		Float value(mpfr_get_prec(out) + GUARD);
+		constant.compute(value.ptr(), MPFR_RNDN);
+		put(name, value);
+		if (round(values.at(name), out, rnd, ternary))
+			return ternary;
+		return constant.compute(out, rnd);
+	}
+	std::cerr << "error: unknown constant " << name << std::endl;
+	mpfr_set_nan(out);
+	return 0;
+}
+
+bool Constants::get(const std::string &name, Float &out)
+{
+	auto it = store().find(name);
+	bool computable = false;
+	for (const auto &constant : known)
+		computable |= name == constant.name;
+	if (it == store().end() && !computable)
+		return false;
+	if (computable)
+	{
+		evaluate(name, out.ptr(), (mpfr_rnd_t)out.getRounding());
+		return true;
+	}
+	// a stored value that cannot be rounded is the best there is
+	int ternary;
+	if (!round(it->second, out.ptr(), (mpfr_rnd_t)out.getRounding(), ternary))
+		mpfr_set(out.ptr(), it->second.ptr(), (mpfr_rnd_t)out.getRounding());
+	return true;
+}
+
+void Constants::put(const std::string &name, const Float &value)
+{
+	std::map<std::string, Float> &values = store();
+	auto it = values.find(name);
+	if (it == values.end())
+		values.emplace(name, value);
+	else if (it->second.getPrecision() < value.getPrecision())
+	{
+		mpfr_set_prec(it->second.ptr(), value.getPrecision());
+		mpfr_set(it->second.ptr(), value.ptr(), MPFR_RNDN);
+	}
+}
+
+Constants::prec_t Constants::precision(const std::string &name)
+{
+	auto it = store().find(name);
+	return it == store().end() ? 0 : it->second.getPrecision();
+}
+
+val Constants::names()
+{
+	val out = val::array();
+	for (const auto &entry : store())
+		out.call<void>("push", entry.first);
+	return out;
+}
+
+void Constants::clear() { store().clear(); }
+
+static const char MAGIC[] = {'G', 'M', 'P', 'C', 1};
+
+val Constants::save()
+{
+	std::vector<uint8_t> out(MAGIC, MAGIC + sizeof(MAGIC));
+	for (const auto &entry : store())
+	{
+		uint32_t length = entry.first.size();
+		for (int i = 0; i < 4; i++)
+			out.push_back(length >> (8 * i));
+		out.insert(out.end(), entry.first.begin(), entry.first.end());
+		entry.second.writeBinary(out);
+	}
+	return val::global("Uint8Array").new_(typed_memory_view(out.size(), out.data()));
+}
+
+int Constants::load(val bytes)
+{
+	val view = val::global("Uint8Array").new_(bytes);
+	std::vector<uint8_t> data(view["length"].as<size_t>());
+	val(typed_memory_view(data.size(), data.data())).call<void>("set", view);
+	if (data.size() < sizeof(MAGIC) || std::memcmp(data.data(), MAGIC, sizeof(MAGIC)))
+	{
+		std::cerr << "error: not a constant store" << std::endl;
+		return 0;
+	}
+	int count = 0;
+	for (size_t at = sizeof(MAGIC); at < data.size();)
+	{
+		uint32_t length = 0;
+		for (int i = 0; i < 4 && at + i < data.size(); i++)
+			length |= (uint32_t)data[at + i] << (8 * i);
+		at += 4;
+		Float value(MPFR_PREC_MIN);
+		size_t read = at + length <= data.size() ? value.readBinary(&data[at + length], data.size() - at - length) : 0;
+		if (!read)
+		{
+			std::cerr << "error: constant store truncated or corrupted after " << count << " entries" << std::endl;
+			break;
+		}
+		std::string name(data.begin() + at, data.begin() + at + length);
+		at += length + read;
+		if (value.getPrecision() > (size_t)precision(name))
+		{
+			put(name, value);
+			count++;
+		}
+	}
+	return count;
+}
@@ -0,0 +1,81 @@
+#include <mpfr.h>
+#include <iostream>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+#include "Context.hpp"
+
+Context::Context()
+	: rounding(mpfr_get_default_rounding_mode()), emin(mpfr_get_emin()), emax(mpfr_get_emax()) {}
+
+int Context::getRounding() const { return rounding; }
+Context::builder_pattern Context::setRounding(int mode) { rounding = static_cast<Float::rnd_t>(mode); }
+Context::exp_t Context::getEmin() const { return emin; }
+Context::exp_t Context::getEmax() const { return emax; }
+
+Context::builder_pattern Context::setEmin(exp_t exp)
+{
+	if (exp < mpfr_get_emin_min() || exp > mpfr_get_emin_max() || exp > emax)
+		std::cerr << "error: emin out of range" << std::endl;
+	else
+		emin = exp;
+}
+
+Context::builder_pattern Context::setEmax(exp_t exp)
+{
+	if (exp < mpfr_get_emax_min() || exp > mpfr_get_emax_max() || exp < emin)
+		std::cerr << "error: emax out of range" << std::endl;
+	else
+		emax = exp;
+}
+
+// while a scope is open the flags live in MPFR
+Context::flags_t Context::getFlags() const { return depth ? mpfr_flags_save() : flags; }
+bool Context::testFlags(flags_t mask) const { return getFlags() & mask; }
+
+Context::builder_pattern Context::clearFlags()
+{
+	if (depth)
+		mpfr_clear_flags();
+	flags = 0;
+}
+
+Context::builder_pattern Context::enter()
+{
+	entered.emplace_back(new Scope(*this));
+}
+
+Context::builder_pattern Context::exit()
+{
+	if (entered.empty())
+		std::cerr << "error: context exit without enter" << std::endl;
+	else
+		entered.pop_back();
+}
+
+void Context::install(Float::rnd_t rounding, exp_t emin, exp_t emax, flags_t flags)
+{
+	if (mpfr_get_default_rounding_mode() != rounding)
+		mpfr_set_default_rounding_mode(rounding);
+	if (mpfr_get_emin() != emin)
+		mpfr_set_emin(emin);
+	if (mpfr_get_emax() != emax)
+		mpfr_set_emax(emax);
+	mpfr_flags_restore(flags, MPFR_FLAGS_ALL);
+}
+
+Context::Scope::Scope(Context &context)
+	: context(context), rounding(mpfr_get_default_rounding_mode()), emin(mpfr_get_emin()), emax(mpfr_get_emax()), flags(mpfr_flags_save())
+{
+	// a nested scope of the same context keeps the live flags
+	install(context.rounding, context.emin, context.emax, context.depth ? flags : context.flags);
+	context.depth++;
+}
+
+Context::Scope::~Scope()
+{
+	context.flags = mpfr_flags_save();
+	context.depth--;
+	install(rounding, emin, emax, context.depth ? context.flags : flags);
+}
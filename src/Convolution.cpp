@@ -0,0 +1,366 @@
+#include <mpfr.h>
+#include <gmp.h>
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+#include "Convolution.hpp"
+#include "Accumulator.hpp"
+#include "Formula.hpp"
+#include "Trace.hpp"
+
+typedef Convolution::exp_t exp_t;
+
+// shortest sequence for Kronecker with "auto"
+static const size_t KRONECKER = 8;
+// schoolbook below this length inside Karatsuba
+static const size_t SCHOOLBOOK = 8;
+// bits kept beyond precision + log2(n) in the fixed point conversion
+static const size_t GUARD = 8;
+
+// integers z_i with x_i ~ z_i 2^scale
+struct Sequence
+{
+	std::vector<__mpz_struct> z;
+	exp_t scale = 0;
+
+	Sequence(size_t n) : z(n)
+	{
+		for (__mpz_struct &c : z)
+			mpz_init(&c);
+	}
+	Sequence(const Sequence &) = delete;
+	Sequence &operator=(const Sequence &) = delete;
+	~Sequence()
+	{
+		for (__mpz_struct &c : z)
+			mpz_clear(&c);
+	}
+
+	size_t bits() const
+	{
+		size_t out = 0;
+		for (const __mpz_struct &c : z)
+			out = std::max(out, mpz_sizeinbase(&c, 2));
+		return out;
+	}
+};
+
+static size_t bitLength(size_t n)
+{
+	size_t bits = 0;
+	for (; n; n >>= 1)
+		bits++;
+	return bits;
+}
+
+// exact when the nonzero x span at most keep bits, otherwise rounded to
+// keep bits below the largest
+static void fixed(const std::vector<mpfr_srcptr> &x, size_t keep, Sequence &s)
+{
+	bool any = false;
+	exp_t top = 0, low = 0;
+	for (mpfr_srcptr v : x)
+	{
+		if (mpfr_zero_p(v))
+			continue;
+		exp_t e = mpfr_get_exp(v), lsb = e - mpfr_min_prec(v);
+		top = any ? std::max(top, e) : e;
+		low = any ? std::min(low, lsb) : lsb;
+		any = true;
+	}
+	s.scale = any ? std::max(low, top - (exp_t)keep) : 0;
+	for (size_t i = 0; i < x.size(); i++)
+	{
+		mpz_ptr z = &s.z[i];
+		if (mpfr_zero_p(x[i]))
+		{
+			mpz_set_ui(z, 0);
+			continue;
+		}
+		exp_t e = mpfr_get_z_2exp(z, x[i]);
+		if (e >= s.scale)
+			mpz_mul_2exp(z, z, e - s.scale);
+		else
+		{
+			// to nearest, ties up
+			mp_bitcnt_t shift = s.scale - e;
+			if (shift > mpz_sizeinbase(z, 2) + 1)
+				mpz_set_ui(z, 0);
+			else
+			{
+				mpz_t half;
+				mpz_init_set_ui(half, 1);
+				mpz_mul_2exp(half, half, shift - 1);
+				mpz_add(z, z, half);
+				mpz_fdiv_q_2exp(z, z, shift);
+				mpz_clear(half);
+			}
+		}
+	}
+}
+
+// c += a b
+static void schoolbook(const __mpz_struct *a, size_t na, const __mpz_struct *b, size_t nb, __mpz_struct *c)
+{
+	for (size_t i = 0; i < na; i++)
+		for (size_t j = 0; j < nb; j++)
+			mpz_addmul(&c[i + j], &a[i], &b[j]);
+}
+
+// c += a b, with a = a0 + x^h a1 and b = b0 + x^h b1:
+// a b = a0 b0 + x^h ((a0 + a1) (b0 + b1) - a0 b0 - a1 b1) + x^2h a1 b1
+static void karatsuba(const __mpz_struct *a, size_t na, const __mpz_struct *b, size_t nb, __mpz_struct *c)
+{
+	if (na < nb)
+	{
+		std::swap(a, b);
+		std::swap(na, nb);
+	}
+	if (nb <= SCHOOLBOOK)
+	{
+		schoolbook(a, na, b, nb, c);
+		return;
+	}
+	// unbalanced: a in pieces of the length of b
+	if (2 * nb <= na + 1)
+	{
+		for (size_t i = 0; i < na; i += nb)
+			karatsuba(a + i, std::min(nb, na - i), b, nb, c + i);
+		return;
+	}
+	size_t h = (na + 1) / 2;
+	Sequence s(h), t(h), low(2 * h - 1), middle(2 * h - 1), high(na + nb - 2 * h - 1);
+	for (size_t i = 0; i < h; i++)
+	{
+		mpz_set(&s.z[i], &a[i]);
+		mpz_set(&t.z[i], &b[i]);
+		if (h + i < na)
+			mpz_add(&s.z[i], &s.z[i], &a[h + i]);
+		if (h + i < nb)
+			mpz_add(&t.z[i], &t.z[i], &b[h + i]);
+	}
+	karatsuba(a, h, b, h, low.z.data());
+	karatsuba(a + h, na - h, b + h, nb - h, high.z.data());
+	karatsuba(s.z.data(), h, t.z.data(), h, middle.z.data());
+	for (size_t i = 0; i < low.z.size(); i++)
+	{
+		mpz_sub(&middle.z[i], &middle.z[i], &low.z[i]);
+		mpz_add(&c[i], &c[i], &low.z[i]);
+	}
+	for (size_t i = 0; i < high.z.size(); i++)
+	{
+		mpz_sub(&middle.z[i], &middle.z[i], &high.z[i]);
+		mpz_add(&c[2 * h + i], &c[2 * h + i], &high.z[i]);
+	}
+	for (size_t i = 0; i < middle.z.size(); i++)
+		mpz_add(&c[h + i], &c[h + i], &middle.z[i]);
+}
+
+// out = sum z_i 2^(w i), the |z_i| < 2^w of each sign go in disjoint slots
+static void pack(const Sequence &s, size_t w, mpz_ptr out)
+{
+	size_t limbs = s.z.size() * w / GMP_NUMB_BITS + 2;
+	std::vector<mp_limb_t> positive(limbs), negative(limbs), shifted;
+	for (size_t i = 0; i < s.z.size(); i++)
+	{
+		mpz_srcptr c = &s.z[i];
+		size_t n = mpz_size(c);
+		if (!n)
+			continue;
+		size_t bit = w * i, at = bit / GMP_NUMB_BITS;
+		unsigned shift = bit % GMP_NUMB_BITS;
+		mp_limb_t *to = (mpz_sgn(c) < 0 ? negative : positive).data() + at;
+		const mp_limb_t *from = mpz_limbs_read(c);
+		shifted.assign(n + 1, 0);
+		if (shift)
+			shifted[n] = mpn_lshift(shifted.data(), from, n, shift);
+		else
+			std::copy(from, from + n, shifted.begin());
+		for (size_t k = 0; k <= n; k++)
+			to[k] |= shifted[k];
+	}
+	size_t np = limbs, nn = limbs;
+	while (np && !positive[np - 1])
+		np--;
+	while (nn && !negative[nn - 1])
+		nn--;
+	__mpz_struct p, q;
+	mpz_sub(out, mpz_roinit_n(&p, positive.data(), np), mpz_roinit_n(&q, negative.data(), nn));
+}
+
+// r = bits [bit, bit + w) of the limbs d[0, n)
+static void field(mpz_ptr r, const mp_limb_t *d, size_t n, size_t bit, size_t w)
+{
+	size_t at = bit / GMP_NUMB_BITS;
+	unsigned shift = bit % GMP_NUMB_BITS;
+	if (at >= n)
+	{
+		mpz_set_ui(r, 0);
+		return;
+	}
+	size_t count = std::min(n - at, (shift + w) / GMP_NUMB_BITS + 1);
+	mp_limb_t *out = mpz_limbs_write(r, count);
+	if (shift)
+		mpn_rshift(out, d + at, count, shift);
+	else
+		std::copy(d + at, d + at + count, out);
+	size_t whole = w / GMP_NUMB_BITS, size = count;
+	unsigned rest = w % GMP_NUMB_BITS;
+	if (size > whole + (rest ? 1 : 0))
+		size = whole + (rest ? 1 : 0);
+	if (rest && size == whole + 1)
+		out[whole] &= ((mp_limb_t)1 << rest) - 1;
+	while (size && !out[size - 1])
+		size--;
+	mpz_limbs_finish(r, size);
+}
+
+// Kronecker substitution: the slots of w bits hold the |c_k| < 2^(w-1) as
+// balanced digits, read back from the low end with a borrow
+static void kronecker(const Sequence &a, const Sequence &b, Sequence &c)
+{
+	size_t w = a.bits() + b.bits() + bitLength(std::min(a.z.size(), b.z.size())) + 1;
+	mpz_t x, y, r, half;
+	mpz_inits(x, y, r, half, nullptr);
+	pack(a, w, x);
+	pack(b, w, y);
+	mpz_mul(x, x, y);
+	mpz_setbit(half, w - 1);
+	int sign = mpz_sgn(x);
+	const mp_limb_t *d = mpz_limbs_read(x);
+	size_t n = mpz_size(x);
+	bool borrow = false;
+	for (size_t k = 0; k < c.z.size(); k++)
+	{
+		field(r, d, n, w * k, w);
+		if (borrow)
+			mpz_add_ui(r, r, 1);
+		borrow = mpz_cmp(r, half) >= 0;
+		if (borrow)
+		{
+			mpz_sub(r, r, half);
+			mpz_sub(r, r, half);
+		}
+		if (sign < 0)
+			mpz_neg(&c.z[k], r);
+		else
+			mpz_swap(&c.z[k], r);
+	}
+	mpz_clears(x, y, r, half, nullptr);
+}
+
+// FloatArrays are read in place, the other elements go through holder
+static std::vector<mpfr_srcptr> elements(val x, std::vector<Float> &holder)
+{
+	if (x.instanceof(val::module_property("FloatArray")))
+	{
+		const FloatArray &array = x.as<const FloatArray &>();
+		std::vector<mpfr_srcptr> out(array.size());
+		for (size_t i = 0; i < out.size(); i++)
+			out[i] = array.at(i);
+		return out;
+	}
+	if (!Accumulator::isFloat64Array(x))
+		return Formula::arguments(x, holder);
+	std::vector<double> copy;
+	const double *d = Accumulator::doubles(x, copy);
+	size_t n = x["length"].as<size_t>();
+	std::vector<mpfr_srcptr> out(n);
+	holder.reserve(n);
+	for (size_t i = 0; i < n; i++)
+	{
+		holder.emplace_back(53, d[i]);
+		out[i] = holder.back().ptr();
+	}
+	return out;
+}
+
+// exact products summed with a single rounding
+static void direct(const std::vector<mpfr_srcptr> &a, const std::vector<mpfr_srcptr> &b, FloatArray &out, mpfr_rnd_t rounding)
+{
+	size_t m = std::min(a.size(), b.size());
+	std::vector<Float> products(m, Float(MPFR_PREC_MIN));
+	std::vector<mpfr_ptr> terms(m);
+	for (size_t k = 0; k < out.size(); k++)
+	{
+		size_t first = k < b.size() ? 0 : k - b.size() + 1, last = std::min(k, a.size() - 1), count = 0;
+		for (size_t i = first; i <= last; i++, count++)
+		{
+			mpfr_ptr p = products[count].ptr();
+			mpfr_set_prec(p, mpfr_get_prec(a[i]) + mpfr_get_prec(b[k - i]));
+			mpfr_mul(p, a[i], b[k - i], MPFR_RNDN);
+			terms[count] = p;
+		}
+		mpfr_sum(out.at(k), terms.data(), count, rounding);
+	}
+}
+
+Convolution::Convolution(prec_t precision) : precision(precision) {}
+
+Convolution::prec_t Convolution::getPrecision() const { return precision; }
+Convolution::builder_pattern Convolution::setPrecision(prec_t precision) { this->precision = precision; }
+int Convolution::getRounding() const { return rounding; }
+Convolution::builder_pattern Convolution::setRounding(int mode) { rounding = static_cast<Float::rnd_t>(mode); }
+std::string Convolution::getMethod() const { return method; }
+std::string Convolution::getUsed() const { return used; }
+
+Convolution::builder_pattern Convolution::setMethod(std::string method)
+{
+	if (method != "auto" && method != "direct" && method != "karatsuba" && method != "kronecker")
+	{
+		std::cerr << "error: unknown convolution method " << method << std::endl;
+		return;
+	}
+	this->method = method;
+}
+
+FloatArray Convolution::convolve(val a, val b)
+{
+	std::vector<Float> holderA, holderB;
+	std::vector<mpfr_srcptr> x = elements(a, holderA), y = elements(b, holderB);
+	FloatArray out(x.empty() || y.empty() ? 0 : x.size() + y.size() - 1, precision);
+	out.setRounding(rounding);
+	convolve(x, y, out);
+	return out;
+}
+
+void Convolution::convolve(const std::vector<mpfr_srcptr> &a, const std::vector<mpfr_srcptr> &b, FloatArray &out)
+{
+	Trace::Span span("Convolution.convolve", precision);
+	if (a.empty() || b.empty())
+		return;
+	size_t m = std::min(a.size(), b.size());
+	bool finite = true;
+	for (mpfr_srcptr v : a)
+		finite &= mpfr_number_p(v) != 0;
+	for (mpfr_srcptr v : b)
+		finite &= mpfr_number_p(v) != 0;
+
+	// NaN and infinities only go through mpfr
+	used = method;
+	if (!finite)
+		used = "direct";
+	else if (method == "auto")
+		used = m < KRONECKER ? "direct" : "kronecker";
+	if (used == "direct")
+	{
+		direct(a, b, out, rounding);
+		return;
+	}
+
+	size_t keep = precision + bitLength(m) + GUARD;
+	Sequence x(a.size()), y(b.size()), z(out.size());
+	fixed(a, keep, x);
+	fixed(b, keep, y);
+	if (used == "karatsuba")
+		karatsuba(x.z.data(), x.z.size(), y.z.data(), y.z.size(), z.z.data());
+	else
+		kronecker(x, y, z);
+	for (size_t k = 0; k < out.size(); k++)
+		mpfr_set_z_2exp(out.at(k), &z.z[k], x.scale + y.scale, rounding);
+}
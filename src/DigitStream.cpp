@@ -0,0 +1,201 @@
+#include <mpfr.h>
+#include <gmp.h>
+#include <cmath>
+#include <cstdlib>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+#include "DigitStream.hpp"
+
+DigitStream::DigitStream(const Float &op, int base, int n, size_t chunk)
+	: base(base), chunk(chunk ? chunk : 1)
+{
+	mpfr_srcptr x = op.ptr();
+	negative = mpfr_signbit(x);
+	if (mpfr_nan_p(x))
+	{
+		special = "@NaN@";
+		return;
+	}
+	if (mpfr_inf_p(x))
+	{
+		special = negative ? "-@Inf@" : "@Inf@";
+		return;
+	}
+	ndigits = n > 0 ? n : mpfr_get_str_ndigits(base, mpfr_get_prec(x));
+
+	mpz_t N;
+	mpz_init(N);
+	if (!mpfr_zero_p(x))
+	{
+		mpz_t m, upper, lower;
+		mpz_inits(m, upper, lower, nullptr);
+		exp_t e2 = mpfr_get_z_2exp(m, x);
+		mpz_abs(m, m);
+		mpz_ui_pow_ui(upper, base, ndigits);
+		mpz_ui_pow_ui(lower, base, ndigits - 1);
+
+		// x = 0.ddd * base^e, the estimate can only be off by one
+		exp_t e = (exp_t)std::floor((mpfr_get_exp(x) - 1) * (std::log(2.0) / std::log((double)base))) + 1;
+		for (int tries = 0; tries < 4; tries++)
+		{
+			scale(N, m, e2, e, (mpfr_rnd_t)op.getRounding(), negative);
+			if (mpz_cmp(N, upper) >= 0)
+				e++;
+			else if (mpz_cmp(N, lower) < 0)
+				e--;
+			else
+				break;
+		}
+		exponent = e - 1;
+		mpz_clears(m, upper, lower, nullptr);
+	}
+	pushPiece(N, ndigits);
+	mpz_clear(N);
+}
+
+DigitStream::~DigitStream()
+{
+	for (Piece &piece : pending)
+		mpz_clear(&piece.value);
+	for (__mpz_struct &p : powers)
+		mpz_clear(&p);
+}
+
+bool DigitStream::done() const { return finished; }
+DigitStream::exp_t DigitStream::getExponent() const { return exponent; }
+size_t DigitStream::getDigits() const { return ndigits; }
+
+// next() returns a view on an internal buffer, only valid until the following call
+val DigitStream::next()
+{
+	buffer.clear();
+	if (finished)
+		return val(typed_memory_view(0, (const unsigned char *)buffer.data()));
+	if (!special.empty())
+	{
+		buffer = special;
+		finished = true;
+		return val(typed_memory_view(buffer.size(), (const unsigned char *)buffer.data()));
+	}
+	if (!started && negative)
+		buffer += '-';
+
+	while (!pending.empty())
+	{
+		Piece top = pending.back();
+		pending.pop_back();
+		if (top.digits <= chunk)
+		{
+			emitLeaf(top);
+			mpz_clear(&top.value);
+			break;
+		}
+
+		// split so that every low part is a whole number of chunks
+		size_t k = 0;
+		while ((chunk << (k + 1)) < top.digits)
+			k++;
+		Piece hi, lo;
+		mpz_init(&hi.value);
+		mpz_init(&lo.value);
+		mpz_tdiv_qr(&hi.value, &lo.value, &top.value, power(k));
+		lo.digits = chunk << k;
+		hi.digits = top.digits - lo.digits;
+		mpz_clear(&top.value);
+		pending.push_back(lo);
+		pending.push_back(hi);
+	}
+
+	if (pending.empty())
+	{
+		buffer += 'e';
+		buffer += exponent < 0 ? '-' : '+';
+		buffer += std::to_string(std::labs(exponent));
+		finished = true;
+	}
+	return val(typed_memory_view(buffer.size(), (const unsigned char *)buffer.data()));
+}
+
+// out = round(|m| * 2^e2 * base^(ndigits - e)) in the direction rnd applies to the signed value
+void DigitStream::scale(mpz_ptr out, mpz_srcptr mantissa, exp_t e2, exp_t e, mpfr_rnd_t rnd, bool neg)
+{
+	exp_t s = (exp_t)ndigits - e;
+	mpz_t num, den, r;
+	mpz_init_set(num, mantissa);
+	mpz_init_set_ui(den, 1);
+	mpz_init(r);
+
+	if (s > 0)
+	{
+		mpz_ui_pow_ui(r, base, s);
+		mpz_mul(num, num, r);
+	}
+	else if (s < 0)
+		mpz_ui_pow_ui(den, base, -s);
+	if (e2 > 0)
+		mpz_mul_2exp(num, num, e2);
+	else if (e2 < 0)
+		mpz_mul_2exp(den, den, -e2);
+
+	mpz_tdiv_qr(out, r, num, den);
+	if (mpz_sgn(r))
+	{
+		bool up;
+		if (rnd == MPFR_RNDN)
+		{
+			mpz_mul_2exp(r, r, 1);
+			int c = mpz_cmp(r, den);
+			up = c > 0 || (c == 0 && mpz_odd_p(out));
+		}
+		else
+			up = rnd == MPFR_RNDA || (rnd == MPFR_RNDU && !neg) || (rnd == MPFR_RNDD && neg);
+		if (up)
+			mpz_add_ui(out, out, 1);
+	}
+	mpz_clears(num, den, r, nullptr);
+}
+
+// base^(chunk * 2^k), computed once by repeated squaring
+mpz_srcptr DigitStream::power(size_t k)
+{
+	while (powers.size() <= k)
+	{
+		__mpz_struct p;
+		mpz_init(&p);
+		if (powers.empty())
+			mpz_ui_pow_ui(&p, base, chunk);
+		else
+			mpz_mul(&p, &powers.back(), &powers.back());
+		powers.push_back(p);
+	}
+	return &powers[k];
+}
+
+void DigitStream::pushPiece(mpz_srcptr value, size_t digits)
+{
+	Piece piece;
+	mpz_init_set(&piece.value, value);
+	piece.digits = digits;
+	pending.push_back(piece);
+}
+
+void DigitStream::emitLeaf(Piece &leaf)
+{
+	std::string digits(mpz_sizeinbase(&leaf.value, base) + 2, '\0');
+	mpz_get_str(&digits[0], base, &leaf.value);
+	digits.resize(std::char_traits<char>::length(digits.c_str()));
+	if (digits.size() < leaf.digits)
+		digits.insert(0, leaf.digits - digits.size(), '0');
+
+	if (!started)
+	{
+		started = true;
+		buffer += digits[0];
+		buffer += '.';
+		buffer.append(digits, 1, std::string::npos);
+	}
+	else
+		buffer += digits;
+}
@@ -0,0 +1,520 @@
+#include <mpfr.h>
+#include <iostream>
+#include <vector>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+#include "Dual.hpp"
+#include "Constants.hpp"
+
+static const mpfr_rnd_t N = MPFR_RNDN;
+
+Dual::Dual(size_t directions, prec_t precision) : value(precision)
+{
+	mpfr_set_zero(value.ptr(), 1);
+	derivatives.reserve(directions);
+	for (size_t i = 0; i < directions; i++)
+	{
+		derivatives.emplace_back(precision);
+		mpfr_set_zero(derivatives[i].ptr(), 1);
+	}
+}
+
+size_t Dual::getDirections() const { return derivatives.size(); }
+Dual::prec_t Dual::getPrecision() const { return mpfr_get_prec(value.ptr()); }
+int Dual::getRounding() const { return rounding; }
+Dual::builder_pattern Dual::setRounding(int rounding) { this->rounding = (mpfr_rnd_t)rounding; }
+
+Dual::builder_pattern Dual::seed(val v, int direction)
+{
+	setValue(v);
+	for (size_t i = 0; i < derivatives.size(); i++)
+		mpfr_set_si(derivatives[i].ptr(), (int)i == direction, N);
+}
+
+Dual::builder_pattern Dual::set(const Dual &other)
+{
+	if (other.derivatives.size() != derivatives.size())
+	{
+		std::cerr << "error: dual with " << other.derivatives.size() << " directions, expected " << derivatives.size() << std::endl;
+		return;
+	}
+	mpfr_set(value.ptr(), other.value.ptr(), rounding);
+	for (size_t i = 0; i < derivatives.size(); i++)
+		mpfr_set(derivatives[i].ptr(), other.derivatives[i].ptr(), N);
+}
+
+Dual::builder_pattern Dual::setValue(val v)
+{
+	Float c(getPrecision());
+	c.setRounding(rounding);
+	c.set(v);
+	mpfr_swap(value.ptr(), c.ptr());
+}
+
+Dual::builder_pattern Dual::setDerivative(size_t direction, val v)
+{
+	if (direction >= derivatives.size())
+	{
+		std::cerr << "error: direction " << direction << " out of range" << std::endl;
+		return;
+	}
+	Float c(getPrecision());
+	c.set(v);
+	mpfr_swap(derivatives[direction].ptr(), c.ptr());
+}
+
+Float Dual::getValue() const { return value; }
+
+Float Dual::getDerivative(size_t direction) const
+{
+	if (direction >= derivatives.size())
+	{
+		std::cerr << "error: direction " << direction << " out of range" << std::endl;
+		return Float(getPrecision());
+	}
+	return derivatives[direction];
+}
+
+FloatArray Dual::gradient() const
+{
+	FloatArray out(derivatives.size(), getPrecision());
+	for (size_t i = 0; i < derivatives.size(); i++)
+		mpfr_set(out.at(i), derivatives[i].ptr(), N);
+	return out;
+}
+
+const Dual *Dual::operand(val v, Float &c) const
+{
+	if (v.instanceof(val::module_property("Dual")))
+	{
+		const Dual &other = v.as<const Dual &>();
+		if (other.derivatives.size() == derivatives.size())
+			return &other;
+		std::cerr << "error: dual with " << other.derivatives.size() << " directions, expected " << derivatives.size() << std::endl;
+		mpfr_set_nan(c.ptr());
+		return nullptr;
+	}
+	c.setRounding(rounding);
+	c.set(v);
+	return nullptr;
+}
+
+void Dual::chain(mpfr_srcptr df)
+{
+	for (Float &d : derivatives)
+		mpfr_mul(d.ptr(), d.ptr(), df, N);
+}
+
+void Dual::unary(int (*f)(mpfr_ptr, mpfr_srcptr, mpfr_rnd_t), void (*derivative)(mpfr_ptr df, mpfr_srcptr x, mpfr_srcptr y))
+{
+	Float y(getPrecision()), df(getPrecision());
+	f(y.ptr(), value.ptr(), rounding);
+	derivative(df.ptr(), value.ptr(), y.ptr());
+	chain(df.ptr());
+	mpfr_swap(value.ptr(), y.ptr());
+}
+
+// arithmetic
+
+Dual::builder_pattern Dual::add(val v)
+{
+	Float c(getPrecision());
+	const Dual *b = operand(v, c);
+	if (!b)
+	{
+		mpfr_add(value.ptr(), value.ptr(), c.ptr(), rounding);
+		return;
+	}
+	for (size_t i = 0; i < derivatives.size(); i++)
+		mpfr_add(derivatives[i].ptr(), derivatives[i].ptr(), b->derivatives[i].ptr(), N);
+	mpfr_add(value.ptr(), value.ptr(), b->value.ptr(), rounding);
+}
+
+Dual::builder_pattern Dual::sub(val v)
+{
+	Float c(getPrecision());
+	const Dual *b = operand(v, c);
+	if (!b)
+	{
+		mpfr_sub(value.ptr(), value.ptr(), c.ptr(), rounding);
+		return;
+	}
+	for (size_t i = 0; i < derivatives.size(); i++)
+		mpfr_sub(derivatives[i].ptr(), derivatives[i].ptr(), b->derivatives[i].ptr(), N);
+	mpfr_sub(value.ptr(), value.ptr(), b->value.ptr(), rounding);
+}
+
+// (ab)' = a'b + ab', one rounding per direction
+Dual::builder_pattern Dual::mul(val v)
+{
+	Float c(getPrecision());
+	const Dual *b = operand(v, c);
+	if (!b)
+	{
+		chain(c.ptr());
+		mpfr_mul(value.ptr(), value.ptr(), c.ptr(), rounding);
+		return;
+	}
+	for (size_t i = 0; i < derivatives.size(); i++)
+		mpfr_fmma(derivatives[i].ptr(), derivatives[i].ptr(), b->value.ptr(), value.ptr(), b->derivatives[i].ptr(), N);
+	mpfr_mul(value.ptr(), value.ptr(), b->value.ptr(), rounding);
+}
+
+// (a/b)' = (a' - (a/b) b') / b
+Dual::builder_pattern Dual::div(val v)
+{
+	Float c(getPrecision());
+	const Dual *b = operand(v, c);
+	if (!b)
+	{
+		for (Float &d : derivatives)
+			mpfr_div(d.ptr(), d.ptr(), c.ptr(), N);
+		mpfr_div(value.ptr(), value.ptr(), c.ptr(), rounding);
+		return;
+	}
+	Float q(getPrecision()), t(getPrecision());
+	mpfr_div(q.ptr(), value.ptr(), b->value.ptr(), N);
+	for (size_t i = 0; i < derivatives.size(); i++)
+	{
+		mpfr_fms(t.ptr(), q.ptr(), b->derivatives[i].ptr(), derivatives[i].ptr(), N);
+		mpfr_div(derivatives[i].ptr(), t.ptr(), b->value.ptr(), N);
+		mpfr_neg(derivatives[i].ptr(), derivatives[i].ptr(), N);
+	}
+	mpfr_div(value.ptr(), value.ptr(), b->value.ptr(), rounding);
+}
+
+// (a^b)' = b a^(b-1) a' + a^b log(a) b', the log term only along the
+// directions where b' is not zero, so a negative a with a constant exponent
+// keeps finite derivatives
+Dual::builder_pattern Dual::pow(val v)
+{
+	Float c(getPrecision()), y(getPrecision()), da(getPrecision()), db(getPrecision());
+	const Dual *b = operand(v, c);
+	mpfr_srcptr e = b ? b->value.ptr() : c.ptr();
+	mpfr_pow(y.ptr(), value.ptr(), e, rounding);
+	mpfr_sub_ui(da.ptr(), e, 1, N);
+	mpfr_pow(da.ptr(), value.ptr(), da.ptr(), N);
+	mpfr_mul(da.ptr(), da.ptr(), e, N);
+	if (b)
+	{
+		mpfr_log(db.ptr(), value.ptr(), N);
+		mpfr_mul(db.ptr(), db.ptr(), y.ptr(), N);
+	}
+	for (size_t i = 0; i < derivatives.size(); i++)
+	{
+		if (b && !mpfr_zero_p(b->derivatives[i].ptr()))
+			mpfr_fmma(derivatives[i].ptr(), derivatives[i].ptr(), da.ptr(), b->derivatives[i].ptr(), db.ptr(), N);
+		else
+			mpfr_mul(derivatives[i].ptr(), derivatives[i].ptr(), da.ptr(), N);
+	}
+	mpfr_swap(value.ptr(), y.ptr());
+}
+
+Dual::builder_pattern Dual::pow_si(long n)
+{
+	Float df(getPrecision());
+	mpfr_pow_si(df.ptr(), value.ptr(), n - 1, N);
+	mpfr_mul_si(df.ptr(), df.ptr(), n, N);
+	chain(df.ptr());
+	mpfr_pow_si(value.ptr(), value.ptr(), n, rounding);
+}
+
+Dual::builder_pattern Dual::neg()
+{
+	for (Float &d : derivatives)
+		mpfr_neg(d.ptr(), d.ptr(), N);
+	mpfr_neg(value.ptr(), value.ptr(), rounding);
+}
+
+// derivative 0 at 0
+Dual::builder_pattern Dual::abs()
+{
+	unary(mpfr_abs, [](mpfr_ptr df, mpfr_srcptr x, mpfr_srcptr) { mpfr_set_si(df, mpfr_sgn(x), N); });
+}
+
+Dual::builder_pattern Dual::sqr()
+{
+	unary(mpfr_sqr, [](mpfr_ptr df, mpfr_srcptr x, mpfr_srcptr) { mpfr_mul_2ui(df, x, 1, N); });
+}
+
+Dual::builder_pattern Dual::sqrt()
+{
+	unary(mpfr_sqrt, [](mpfr_ptr df, mpfr_srcptr, mpfr_srcptr y) {
+		mpfr_ui_div(df, 1, y, N);
+		mpfr_div_2ui(df, df, 1, N);
+	});
+}
+
+Dual::builder_pattern Dual::cbrt()
+{
+	unary(mpfr_cbrt, [](mpfr_ptr df, mpfr_srcptr, mpfr_srcptr y) {
+		mpfr_sqr(df, y, N);
+		mpfr_mul_ui(df, df, 3, N);
+		mpfr_ui_div(df, 1, df, N);
+	});
+}
+
+// exponentials and logarithms
+
+Dual::builder_pattern Dual::exp()
+{
+	unary(mpfr_exp, [](mpfr_ptr df, mpfr_srcptr, mpfr_srcptr y) { mpfr_set(df, y, N); });
+}
+
+Dual::builder_pattern Dual::exp2()
+{
+	unary(mpfr_exp2, [](mpfr_ptr df, mpfr_srcptr, mpfr_srcptr y) {
+		Constants::evaluate("log2", df, N);
+		mpfr_mul(df, df, y, N);
+	});
+}
+
+Dual::builder_pattern Dual::exp10()
+{
+	unary(mpfr_exp10, [](mpfr_ptr df, mpfr_srcptr, mpfr_srcptr y) {
+		mpfr_log_ui(df, 10, N);
+		mpfr_mul(df, df, y, N);
+	});
+}
+
+Dual::builder_pattern Dual::expm1()
+{
+	unary(mpfr_expm1, [](mpfr_ptr df, mpfr_srcptr, mpfr_srcptr y) { mpfr_add_ui(df, y, 1, N); });
+}
+
+Dual::builder_pattern Dual::log()
+{
+	unary(mpfr_log, [](mpfr_ptr df, mpfr_srcptr x, mpfr_srcptr) { mpfr_ui_div(df, 1, x, N); });
+}
+
+Dual::builder_pattern Dual::log2()
+{
+	unary(mpfr_log2, [](mpfr_ptr df, mpfr_srcptr x, mpfr_srcptr) {
+		Constants::evaluate("log2", df, N);
+		mpfr_mul(df, df, x, N);
+		mpfr_ui_div(df, 1, df, N);
+	});
+}
+
+Dual::builder_pattern Dual::log10()
+{
+	unary(mpfr_log10, [](mpfr_ptr df, mpfr_srcptr x, mpfr_srcptr) {
+		mpfr_log_ui(df, 10, N);
+		mpfr_mul(df, df, x, N);
+		mpfr_ui_div(df, 1, df, N);
+	});
+}
+
+Dual::builder_pattern Dual::log1p()
+{
+	unary(mpfr_log1p, [](mpfr_ptr df, mpfr_srcptr x, mpfr_srcptr) {
+		mpfr_add_ui(df, x, 1, N);
+		mpfr_ui_div(df, 1, df, N);
+	});
+}
+
+// trigonometric
+
+Dual::builder_pattern Dual::sin()
+{
+	unary(mpfr_sin, [](mpfr_ptr df, mpfr_srcptr x, mpfr_srcptr) { mpfr_cos(df, x, N); });
+}
+
+Dual::builder_pattern Dual::cos()
+{
+	unary(mpfr_cos, [](mpfr_ptr df, mpfr_srcptr x, mpfr_srcptr) {
+		mpfr_sin(df, x, N);
+		mpfr_neg(df, df, N);
+	});
+}
+
+Dual::builder_pattern Dual::tan()
+{
+	unary(mpfr_tan, [](mpfr_ptr df, mpfr_srcptr, mpfr_srcptr y) {
+		mpfr_sqr(df, y, N);
+		mpfr_add_ui(df, df, 1, N);
+	});
+}
+
+Dual::builder_pattern Dual::asin()
+{
+	unary(mpfr_asin, [](mpfr_ptr df, mpfr_srcptr x, mpfr_srcptr) {
+		mpfr_sqr(df, x, N);
+		mpfr_ui_sub(df, 1, df, N);
+		mpfr_rec_sqrt(df, df, N);
+	});
+}
+
+Dual::builder_pattern Dual::acos()
+{
+	unary(mpfr_acos, [](mpfr_ptr df, mpfr_srcptr x, mpfr_srcptr) {
+		mpfr_sqr(df, x, N);
+		mpfr_ui_sub(df, 1, df, N);
+		mpfr_rec_sqrt(df, df, N);
+		mpfr_neg(df, df, N);
+	});
+}
+
+Dual::builder_pattern Dual::atan()
+{
+	unary(mpfr_atan, [](mpfr_ptr df, mpfr_srcptr x, mpfr_srcptr) {
+		mpfr_sqr(df, x, N);
+		mpfr_add_ui(df, df, 1, N);
+		mpfr_ui_div(df, 1, df, N);
+	});
+}
+
+// hyperbolic
+
+Dual::builder_pattern Dual::sinh()
+{
+	unary(mpfr_sinh, [](mpfr_ptr df, mpfr_srcptr x, mpfr_srcptr) { mpfr_cosh(df, x, N); });
+}
+
+Dual::builder_pattern Dual::cosh()
+{
+	unary(mpfr_cosh, [](mpfr_ptr df, mpfr_srcptr x, mpfr_srcptr) { mpfr_sinh(df, x, N); });
+}
+
+Dual::builder_pattern Dual::tanh()
+{
+	unary(mpfr_tanh, [](mpfr_ptr df, mpfr_srcptr, mpfr_srcptr y) {
+		mpfr_sqr(df, y, N);
+		mpfr_ui_sub(df, 1, df, N);
+	});
+}
+
+Dual::builder_pattern Dual::asinh()
+{
+	unary(mpfr_asinh, [](mpfr_ptr df, mpfr_srcptr x, mpfr_srcptr) {
+		mpfr_sqr(df, x, N);
+		mpfr_add_ui(df, df, 1, N);
+		mpfr_rec_sqrt(df, df, N);
+	});
+}
+
+Dual::builder_pattern Dual::acosh()
+{
+	unary(mpfr_acosh, [](mpfr_ptr df, mpfr_srcptr x, mpfr_srcptr) {
+		mpfr_sqr(df, x, N);
+		mpfr_sub_ui(df, df, 1, N);
+		mpfr_rec_sqrt(df, df, N);
+	});
+}
+
+Dual::builder_pattern Dual::atanh()
+{
+	unary(mpfr_atanh, [](mpfr_ptr df, mpfr_srcptr x, mpfr_srcptr) {
+		mpfr_sqr(df, x, N);
+		mpfr_ui_sub(df, 1, df, N);
+		mpfr_ui_div(df, 1, df, N);
+	});
+}
+
+// special functions
+
+Dual::builder_pattern Dual::gamma()
+{
+	unary(mpfr_gamma, [](mpfr_ptr df, mpfr_srcptr x, mpfr_srcptr y) {
+		mpfr_digamma(df, x, N);
+		mpfr_mul(df, df, y, N);
+	});
+}
+
+Dual::builder_pattern Dual::lngamma()
+{
+	unary(mpfr_lngamma, [](mpfr_ptr df, mpfr_srcptr x, mpfr_srcptr) { mpfr_digamma(df, x, N); });
+}
+
+Dual::builder_pattern Dual::eint()
+{
+	unary(mpfr_eint, [](mpfr_ptr df, mpfr_srcptr x, mpfr_srcptr) {
+		mpfr_exp(df, x, N);
+		mpfr_div(df, df, x, N);
+	});
+}
+
+// Li2'(x) = -log(1 - x) / x
+Dual::builder_pattern Dual::li2()
+{
+	unary(mpfr_li2, [](mpfr_ptr df, mpfr_srcptr x, mpfr_srcptr) {
+		mpfr_ui_sub(df, 1, x, N);
+		mpfr_log(df, df, N);
+		mpfr_div(df, df, x, N);
+		mpfr_neg(df, df, N);
+	});
+}
+
+// erf'(x) = 2 exp(-x^2) / sqrt(pi)
+static void erfDerivative(mpfr_ptr df, mpfr_srcptr x)
+{
+	mpfr_t root;
+	mpfr_init2(root, mpfr_get_prec(df));
+	Constants::evaluate("pi", root, N);
+	mpfr_sqrt(root, root, N);
+	mpfr_sqr(df, x, N);
+	mpfr_neg(df, df, N);
+	mpfr_exp(df, df, N);
+	mpfr_div(df, df, root, N);
+	mpfr_mul_2ui(df, df, 1, N);
+	mpfr_clear(root);
+}
+
+Dual::builder_pattern Dual::erf()
+{
+	unary(mpfr_erf, [](mpfr_ptr df, mpfr_srcptr x, mpfr_srcptr) { erfDerivative(df, x); });
+}
+
+Dual::builder_pattern Dual::erfc()
+{
+	unary(mpfr_erfc, [](mpfr_ptr df, mpfr_srcptr x, mpfr_srcptr) {
+		erfDerivative(df, x);
+		mpfr_neg(df, df, N);
+	});
+}
+
+// Bessel: J0' = -J1, J1' = J0 - J1 / x, same for Y
+
+Dual::builder_pattern Dual::j0()
+{
+	unary(mpfr_j0, [](mpfr_ptr df, mpfr_srcptr x, mpfr_srcptr) {
+		mpfr_j1(df, x, N);
+		mpfr_neg(df, df, N);
+	});
+}
+
+Dual::builder_pattern Dual::j1()
+{
+	unary(mpfr_j1, [](mpfr_ptr df, mpfr_srcptr x, mpfr_srcptr y) {
+		mpfr_div(df, y, x, N);
+		mpfr_neg(df, df, N);
+		mpfr_t j;
+		mpfr_init2(j, mpfr_get_prec(df));
+		mpfr_j0(j, x, N);
+		mpfr_add(df, df, j, N);
+		mpfr_clear(j);
+	});
+}
+
+Dual::builder_pattern Dual::y0()
+{
+	unary(mpfr_y0, [](mpfr_ptr df, mpfr_srcptr x, mpfr_srcptr) {
+		mpfr_y1(df, x, N);
+		mpfr_neg(df, df, N);
+	});
+}
+
+Dual::builder_pattern Dual::y1()
+{
+	unary(mpfr_y1, [](mpfr_ptr df, mpfr_srcptr x, mpfr_srcptr y) {
+		mpfr_div(df, y, x, N);
+		mpfr_neg(df, df, N);
+		mpfr_t j;
+		mpfr_init2(j, mpfr_get_prec(df));
+		mpfr_y0(j, x, N);
+		mpfr_add(df, df, j, N);
+		mpfr_clear(j);
+	});
+}
@@ -2,12 +2,20 @@
 #include <iostream>
 #include <emscripten.h>
 #include <emscripten/bind.h>
-#include <sstream>
+#include <algorithm>
+#include <string>
+#include <vector>
 
 using namespace emscripten;
 
 #include "Float.hpp"
 #include "utils.hpp"
+#include "FixedFloat.hpp"
+#include "Accumulator.hpp"
+#include "Constants.hpp"
+#include "Memory.hpp"
+#include "Trace.hpp"
+#include "Context.hpp"
 
 Float::Float()
 {
@@ -17,7 +25,10 @@ Float::Float()
 Float::Float(val v)
 {
 	if (v.isNumber())
-		mpfr_init2(&wrapped, v.as<size_t>());
+	{
+		size_t prec = v.as<size_t>();
+		mpfr_init2(&wrapped, Memory::admit(prec) ? prec : MPFR_PREC_MIN);
+	}
 	else
 	{
 		const Float &op = v.as<const Float &>();
@@ -28,7 +39,7 @@ Float::Float(val v)
 
 Float::Float(prec_t prec)
 {
-	mpfr_init2(&wrapped, prec);
+	mpfr_init2(&wrapped, Memory::admit(prec) ? prec : MPFR_PREC_MIN);
 }
 
 Float::Float(prec_t prec, double v) : Float(prec)
@@ -72,7 +83,10 @@ Float::builder_pattern Float::setRounding(int mode)
 Float::size_t Float::getPrecision() const { return mpfr_get_prec(&wrapped); };
 Float::builder_pattern Float::setPrecision(size_t precision)
 {
-	mpfr_set_prec(&wrapped, precision);
+	if (Memory::admit(precision))
+		mpfr_set_prec(&wrapped, precision);
+	else
+		mpfr_set_nan(&wrapped);
 }
 
 // exponent
@@ -99,6 +113,10 @@ val Float::getMantissaView()
 	return val(typed_memory_view(getMantissaSize() / sizeof(mp_limb_t), wrapped._mpfr_d));
 }
 
+// raw access for the other native classes
+mpfr_ptr Float::ptr() { return &wrapped; }
+mpfr_srcptr Float::ptr() const { return &wrapped; }
+
 // set(string str, base = 10)
 Float::builder_pattern Float::setString(const std::string &str) { return setString(str, 10); }
 Float::builder_pattern Float::setString(const std::string &str, int base)
@@ -113,12 +131,82 @@ Float::builder_pattern Float::setFloat(const Float &tocopy)
 {
 	mpfr_set(&wrapped, &(tocopy).wrapped, rounding);
 }
+// BigInts go through base 16 text, which BigInt and GMP both convert in
+// linear time (limbs are whole hex digits), instead of base 10
+Float::builder_pattern Float::setBigInt(val bigint) { return setBigInt(bigint, 0); }
+Float::builder_pattern Float::setBigInt(val bigint, exp_t scale)
+{
+	std::string hex = bigint.call<std::string>("toString", 16);
+	bool negative = hex[0] == '-';
+	mpz_t z;
+	mpz_init_set_str(z, hex.c_str() + negative, 16);
+	if (negative)
+		mpz_neg(z, z);
+	mpfr_set_z_2exp(&wrapped, z, scale, rounding);
+	mpz_clear(z);
+}
+
+// precision 0 keeps every bit of the integer
+Float Float::fromBigInt(val bigint, prec_t precision) { return fromBigInt(bigint, precision, 0); }
+Float Float::fromBigInt(val bigint, prec_t precision, exp_t scale)
+{
+	if (precision == 0)
+	{
+		std::string hex = bigint.call<std::string>("toString", 2);
+		precision = std::max<prec_t>(MPFR_PREC_MIN, hex.size() - (hex[0] == '-'));
+	}
+	Float out(precision);
+	out.setBigInt(bigint, scale);
+	return out;
+}
+
+// x * 2^scale rounded to an integer with the rounding of x
+val Float::toBigInt() { return toBigInt(0); }
+val Float::toBigInt(exp_t scale)
+{
+	val BigInt = val::global("BigInt");
+	if (!mpfr_number_p(&wrapped))
+	{
+		std::cerr << "error: " << (mpfr_nan_p(&wrapped) ? "NaN" : "infinity") << " has no BigInt value" << std::endl;
+		return BigInt(0);
+	}
+	mpz_t z;
+	mpz_init(z);
+	// m * 2^e exactly, only a negative total shift needs rounding
+	exp_t e = mpfr_get_z_2exp(z, &wrapped) + scale;
+	if (e >= 0)
+		mpz_mul_2exp(z, z, e);
+	else
+	{
+		mpfr_t t;
+		mpfr_init2(t, mpfr_get_prec(&wrapped));
+		mpfr_mul_2si(t, &wrapped, scale, MPFR_RNDN);
+		mpfr_get_z(z, t, rounding);
+		mpfr_clear(t);
+	}
+	// BigInt() takes no sign with 0x, a negative value is read back in
+	// two's complement
+	size_t bits = 0;
+	if (mpz_sgn(z) < 0)
+	{
+		bits = mpz_sizeinbase(z, 2) + 1;
+		mpz_fdiv_r_2exp(z, z, bits);
+	}
+	char *hex = mpz_get_str(nullptr, 16, z);
+	val out = BigInt(std::string("0x") + hex);
+	mpfr_free_str(hex);
+	mpz_clear(z);
+	return bits ? BigInt.call<val>("asIntN", bits, out) : out;
+}
+
 Float::builder_pattern Float::set(val v)
 {
 	if (v.isNumber())
 		return setDouble(v.as<double>());
 	else if (v.isString())
 		return setString(v.as<std::string>());
+	else if (v.typeOf().as<std::string>() == "bigint")
+		return setBigInt(v);
 	else
 		return setFloat(v.as<const Float &>());
 }
@@ -128,18 +216,29 @@ std::string Float::toString(int base) { return toString(base, 0); }
 std::string Float::toString() { return toString(10, 0); }
 std::string Float::toString(int base, int n)
 {
-	std::stringstream ss;
+	// built in place, use DigitStream for very long outputs
+	// NaN and infinities as mpfr writes them, @NaN@, @Inf@ and -@Inf@
+	if (mpfr_nan_p(&wrapped))
+		return "@NaN@";
+	if (mpfr_inf_p(&wrapped))
+		return mpfr_signbit(&wrapped) ? "-@Inf@" : "@Inf@";
 	mpfr_exp_t exp;
 	char *str = mpfr_get_str(nullptr, &exp, base, n, &wrapped, rounding);
-	if (exp)
+	if (mpfr_regular_p(&wrapped))
 		exp--;
-	if (getSign() > 0)
-		ss << str[0] << '.' << &str[1];
-	else
-		ss << '-' << str[1] << '.' << &str[2];
-	ss << "e" << (exp < 0 ? '-' : '+') << ::abs(exp);
+	const char *digits = getSign() > 0 ? str : str + 1;
+	std::string out;
+	out.reserve(std::char_traits<char>::length(digits) + 24);
+	if (getSign() < 0)
+		out += '-';
+	out += digits[0];
+	out += '.';
+	out += &digits[1];
+	out += 'e';
+	out += exp < 0 ? '-' : '+';
+	out += std::to_string(::labs(exp));
 	mpfr_free_str(str);
-	return ss.str();
+	return out;
 }
 
 // toNumber()
@@ -148,6 +247,143 @@ double Float::toNumber()
 	return mpfr_get_d(&wrapped, rounding);
 }
 
+// Binary layout, integers little-endian:
+//   0  version (1)
+//   1  kind: 0 zero, 1 regular, 2 infinity, 3 NaN
+//   2  sign: 0 positive, 1 negative
+//   3  rounding
+//   4  precision, 8 bytes
+//   12 exponent, 8 bytes
+//   20 regular only: the top ceil(precision / 8) bytes of the significand,
+//      least significant first, independent of the limb size
+static const uint8_t BINARY_VERSION = 1;
+static const size_t BINARY_HEADER = 20;
+// largest precision of a zero, NaN or infinity image without a memory
+// budget: nothing in the image bounds it otherwise
+static const uint64_t BINARY_SPECIAL_PREC = 1 << 24;
+
+void Float::writeBinary(std::vector<uint8_t> &out) const
+{
+	prec_t prec = mpfr_get_prec(&wrapped);
+	uint8_t kind = mpfr_zero_p(&wrapped) ? 0 : mpfr_regular_p(&wrapped) ? 1 : mpfr_inf_p(&wrapped) ? 2 : 3;
+	int64_t exp = kind == 1 ? mpfr_get_exp(&wrapped) : 0;
+	out.push_back(BINARY_VERSION);
+	out.push_back(kind);
+	out.push_back(mpfr_signbit(&wrapped) ? 1 : 0);
+	out.push_back(rounding);
+	for (int i = 0; i < 8; i++)
+		out.push_back((uint64_t)prec >> (8 * i));
+	for (int i = 0; i < 8; i++)
+		out.push_back((uint64_t)exp >> (8 * i));
+	if (kind != 1)
+		return;
+	size_t total = mpfr_custom_get_size(prec), bytes = (prec + 7) / 8;
+	for (size_t b = total - bytes; b < total; b++)
+		out.push_back(wrapped._mpfr_d[b / sizeof(mp_limb_t)] >> (8 * (b % sizeof(mp_limb_t))));
+}
+
+// bytes consumed, 0 when the data is not a valid image
+size_t Float::readBinary(const uint8_t *data, size_t size)
+{
+	if (size < BINARY_HEADER || data[0] != BINARY_VERSION || data[1] > 3 || data[3] > MPFR_RNDF)
+		return 0;
+	uint64_t prec = 0, exp = 0;
+	for (int i = 0; i < 8; i++)
+	{
+		prec |= (uint64_t)data[4 + i] << (8 * i);
+		exp |= (uint64_t)data[12 + i] << (8 * i);
+	}
+	if (prec < MPFR_PREC_MIN || prec > MPFR_PREC_MAX)
+		return 0;
+	int sign = data[2] ? -1 : 1;
+	size_t total = mpfr_custom_get_size(prec), bytes = (prec + 7) / 8;
+	if (data[1] == 1 && (size - BINARY_HEADER < bytes || (int64_t)exp < mpfr_get_emin() || (int64_t)exp > mpfr_get_emax() || !(data[BINARY_HEADER + bytes - 1] & 0x80)))
+		return 0;
+	// a zero, NaN or infinity image holds no significand to bound prec, the
+	// allocation goes through the memory budget like a new Float
+	if ((data[1] != 1 && !Memory::getBudget() && prec > BINARY_SPECIAL_PREC) || !Memory::admit(prec))
+		return 0;
+	mpfr_set_prec(&wrapped, prec);
+	rounding = (rnd_t)data[3];
+	switch (data[1])
+	{
+	case 0:
+		mpfr_set_zero(&wrapped, sign);
+		return BINARY_HEADER;
+	case 2:
+		mpfr_set_inf(&wrapped, sign);
+		return BINARY_HEADER;
+	case 3:
+		mpfr_set_nan(&wrapped);
+		wrapped._mpfr_sign = sign;
+		return BINARY_HEADER;
+	}
+	mp_limb_t *d = wrapped._mpfr_d;
+	std::fill(d, d + total / sizeof(mp_limb_t), 0);
+	for (size_t i = 0, b = total - bytes; i < bytes; i++, b++)
+		d[b / sizeof(mp_limb_t)] |= (mp_limb_t)data[BINARY_HEADER + i] << (8 * (b % sizeof(mp_limb_t)));
+	// bits past the precision must stay clear
+	d[0] &= ~(mp_limb_t)0 << (total * 8 - prec);
+	wrapped._mpfr_exp = exp;
+	wrapped._mpfr_sign = sign;
+	return BINARY_HEADER + bytes;
+}
+
+// toBinary(), a Uint8Array copy
+val Float::toBinary()
+{
+	std::vector<uint8_t> out;
+	writeBinary(out);
+	return val::global("Uint8Array").new_(typed_memory_view(out.size(), out.data()));
+}
+
+// Float.fromBinary(Uint8Array | ArrayBuffer)
+Float Float::fromBinary(val bytes)
+{
+	val view = val::global("Uint8Array").new_(bytes);
+	std::vector<uint8_t> data(view["length"].as<size_t>());
+	val(typed_memory_view(data.size(), data.data())).call<void>("set", view);
+	Float out;
+	if (!out.readBinary(data.data(), data.size()))
+	{
+		std::cerr << "error: invalid Float binary image" << std::endl;
+		mpfr_set_nan(&out.wrapped);
+	}
+	return out;
+}
+
+// Over the sign, exponent and significand limbs down to the last nonzero
+// one, so trailing zero limbs from a larger precision do not count. All
+// zeros hash alike, as do all NaNs.
+uint32_t Float::hash() const { return hash(&wrapped); }
+uint32_t Float::hash(mpfr_srcptr x)
+{
+	uint64_t h = 0xcbf29ce484222325;
+	auto mix = [&h](uint64_t v) { h = (h ^ v) * 0x100000001b3; };
+	if (mpfr_nan_p(x))
+		mix(1);
+	else if (mpfr_inf_p(x))
+		mix(mpfr_signbit(x) ? 2 : 3);
+	else if (!mpfr_zero_p(x))
+	{
+		mix(mpfr_signbit(x));
+		mix((uint64_t)mpfr_get_exp(x));
+		const mp_limb_t *d = x->_mpfr_d;
+		size_t low = 0, n = mpfr_custom_get_size(mpfr_get_prec(x)) / sizeof(mp_limb_t);
+		while (!d[low])
+			low++;
+		for (size_t i = n; i-- > low;)
+			mix(d[i]);
+	}
+	// final avalanche (splitmix64) folded to 32 bits
+	h ^= h >> 30;
+	h *= 0xbf58476d1ce4e5b9;
+	h ^= h >> 27;
+	h *= 0x94d049bb133111eb;
+	h ^= h >> 31;
+	return (uint32_t)(h ^ (h >> 32));
+}
+
 bool Float::isInteger()
 {
 	return !!mpfr_integer_p(&wrapped);
@@ -339,30 +575,46 @@ Float::builder_pattern Float::const_catalan() { Float::op_const_catalan(*this);
 
 int Float::op_add(Float &out, const Float &a, val v)
 {
+	Trace::Span span("add", out.getPrecision());
 	if (v.isNumber())
 		return mpfr_add_d(&out.wrapped, &a.wrapped, v.as<double>(), out.rounding);
-	else
-		return mpfr_add(&out.wrapped, &a.wrapped, &v.as<const Float &>().wrapped, out.rounding);
+
+	const Float &b = v.as<const Float &>();
+	int ternary;
+	if (FixedPrecision::add(&out.wrapped, &a.wrapped, &b.wrapped, false, out.rounding, ternary))
+		return ternary;
+	return mpfr_add(&out.wrapped, &a.wrapped, &b.wrapped, out.rounding);
 }
 
 int Float::op_sub(Float &out, const Float &a, val v)
 {
+	Trace::Span span("sub", out.getPrecision());
 	if (v.isNumber())
 		return mpfr_sub_d(&out.wrapped, &a.wrapped, v.as<double>(), out.rounding);
-	else
-		return mpfr_sub(&out.wrapped, &a.wrapped, &v.as<const Float &>().wrapped, out.rounding);
+
+	const Float &b = v.as<const Float &>();
+	int ternary;
+	if (FixedPrecision::add(&out.wrapped, &a.wrapped, &b.wrapped, true, out.rounding, ternary))
+		return ternary;
+	return mpfr_sub(&out.wrapped, &a.wrapped, &b.wrapped, out.rounding);
 }
 
 int Float::op_mul(Float &out, const Float &a, val v)
 {
+	Trace::Span span("mul", out.getPrecision());
 	if (v.isNumber())
 		return mpfr_mul_d(&out.wrapped, &a.wrapped, v.as<double>(), out.rounding);
-	else
-		return mpfr_mul(&out.wrapped, &a.wrapped, &v.as<const Float &>().wrapped, out.rounding);
+
+	const Float &b = v.as<const Float &>();
+	int ternary;
+	if (FixedPrecision::mul(&out.wrapped, &a.wrapped, &b.wrapped, out.rounding, ternary))
+		return ternary;
+	return mpfr_mul(&out.wrapped, &a.wrapped, &b.wrapped, out.rounding);
 }
 
 int Float::op_div(Float &out, const Float &a, val v)
 {
+	Trace::Span span("div", out.getPrecision());
 	if (v.isNumber())
 		return mpfr_div_d(&out.wrapped, &a.wrapped, v.as<double>(), out.rounding);
 	else
@@ -371,56 +623,67 @@ int Float::op_div(Float &out, const Float &a, val v)
 
 int Float::op_sqrt(Float &out, const Float &src)
 {
+	Trace::Span span("sqrt", out.getPrecision());
 	return mpfr_sqrt(&out.wrapped, &src.wrapped, out.rounding);
 }
 
 int Float::op_rec_sqrt(Float &out, const Float &src)
 {
+	Trace::Span span("rec_sqrt", out.getPrecision());
 	return mpfr_rec_sqrt(&out.wrapped, &src.wrapped, out.rounding);
 }
 
 int Float::op_cbrt(Float &out, const Float &src)
 {
+	Trace::Span span("cbrt", out.getPrecision());
 	return mpfr_cbrt(&out.wrapped, &src.wrapped, out.rounding);
 }
 
 int Float::op_root_ui(Float &out, const Float &src, unsigned n)
 {
+	Trace::Span span("root_ui", out.getPrecision());
 	return mpfr_rootn_ui(&out.wrapped, &src.wrapped, n, out.rounding);
 }
 
 int Float::op_neg(Float &out, const Float &src)
 {
+	Trace::Span span("neg", out.getPrecision());
 	return mpfr_neg(&out.wrapped, &src.wrapped, out.rounding);
 }
 
 int Float::op_abs(Float &out, const Float &src)
 {
+	Trace::Span span("abs", out.getPrecision());
 	return mpfr_abs(&out.wrapped, &src.wrapped, out.rounding);
 }
 
 int Float::op_dim(Float &out, const Float &src, const Float &op)
 {
+	Trace::Span span("dim", out.getPrecision());
 	return mpfr_dim(&out.wrapped, &src.wrapped, &op.wrapped, out.rounding);
 }
 
 int Float::op_fma(Float &out, const Float &src, const Float &a, const Float &b)
 {
+	Trace::Span span("fma", out.getPrecision());
 	return mpfr_fma(&out.wrapped, &src.wrapped, &a.wrapped, &b.wrapped, out.rounding);
 }
 
 int Float::op_fms(Float &out, const Float &src, const Float &a, const Float &b)
 {
+	Trace::Span span("fms", out.getPrecision());
 	return mpfr_fms(&out.wrapped, &src.wrapped, &a.wrapped, &b.wrapped, out.rounding);
 }
 
 int Float::op_fmma(Float &out, const Float &src, const Float &a, const Float &b, const Float &c)
 {
+	Trace::Span span("fmma", out.getPrecision());
 	return mpfr_fmma(&out.wrapped, &src.wrapped, &a.wrapped, &b.wrapped, &c.wrapped, out.rounding);
 }
 
 int Float::op_fmms(Float &out, const Float &src, const Float &a, const Float &b, const Float &c)
 {
+	Trace::Span span("fmms", out.getPrecision());
 	return mpfr_fmms(&out.wrapped, &src.wrapped, &a.wrapped, &b.wrapped, &c.wrapped, out.rounding);
 }
 
@@ -432,19 +695,44 @@ void Float::op_swap(Float &a, Float &b)
 
 int Float::op_hypot(Float &out, const Float &x, const Float &y)
 {
+	Trace::Span span("hypot", out.getPrecision());
 	return mpfr_hypot(&out.wrapped, &x.wrapped, &y.wrapped, out.rounding);
 }
 
-int Float::op_sum(Float &out, val array)
+int Float::op_sum(Float &out, val array) { return sum(out, array, out.rounding); }
+
+int Float::op_sum(Float &out, val array, Context &context)
+{
+	Context::Scope scope(context);
+	return sum(out, array, (rnd_t)context.getRounding());
+}
+
+int Float::sum(Float &out, val array, rnd_t rnd)
 {
+	Trace::Span span("sum", out.getPrecision());
+	if (Accumulator::isFloat64Array(array))
+	{
+		Accumulator exact(out.getPrecision());
+		exact.addAll(array);
+		return exact.round(&out.wrapped, rnd);
+	}
 	int length = array["length"].as<int>();
-	mpfr_ptr v[length];
-	jsArrayToMpfrArray(array, v, length);
-	return mpfr_sum(&out.wrapped, v, length, out.rounding);
+	std::vector<mpfr_ptr> v(length);
+	jsArrayToMpfrArray(array, v.data(), length);
+	return mpfr_sum(&out.wrapped, v.data(), length, rnd);
 }
 
-int Float::op_dot(Float &out, val a, val b)
+int Float::op_dot(Float &out, val a, val b) { return dot(out, a, b, out.rounding); }
+
+int Float::op_dot(Float &out, val a, val b, Context &context)
+{
+	Context::Scope scope(context);
+	return dot(out, a, b, (rnd_t)context.getRounding());
+}
+
+int Float::dot(Float &out, val a, val b, rnd_t rnd)
 {
+	Trace::Span span("dot", out.getPrecision());
 	int alength = a["length"].as<int>();
 	int blength = b["length"].as<int>();
 	if (alength != blength)
@@ -452,15 +740,21 @@ int Float::op_dot(Float &out, val a, val b)
 		std::cerr << "error: dot product of array of different size" << std::endl;
 		return 0;
 	}
-	mpfr_ptr aa[alength];
-	mpfr_ptr bb[blength];
-	jsArrayToMpfrArray(a, aa, alength);
-	jsArrayToMpfrArray(b, bb, blength);
-	return mpfr_dot(&out.wrapped, aa, bb, alength, out.rounding);
+	if (Accumulator::isFloat64Array(a) && Accumulator::isFloat64Array(b))
+	{
+		Accumulator exact(out.getPrecision());
+		exact.addDot(a, b);
+		return exact.round(&out.wrapped, rnd);
+	}
+	std::vector<mpfr_ptr> aa(alength), bb(blength);
+	jsArrayToMpfrArray(a, aa.data(), alength);
+	jsArrayToMpfrArray(b, bb.data(), blength);
+	return mpfr_dot(&out.wrapped, aa.data(), bb.data(), alength, rnd);
 }
 
 int Float::op_fac(Float &out, unsigned n)
 {
+	Trace::Span span("fac", out.getPrecision());
 	return mpfr_fac_ui(&out.wrapped, n, out.rounding);
 }
 
@@ -482,201 +776,241 @@ int Float::op_rint_trunc(Float &out, const Float &op) { return mpfr_rint_trunc(&
 
 int Float::op_log(Float &out, const Float &op)
 {
+	Trace::Span span("log", out.getPrecision());
 	return mpfr_log(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_log_ui(Float &out, unsigned long op)
 {
+	Trace::Span span("log_ui", out.getPrecision());
 	return mpfr_log_ui(&out.wrapped, op, out.rounding);
 };
 
 int Float::op_log2(Float &out, const Float &op)
 {
+	Trace::Span span("log2", out.getPrecision());
 	return mpfr_log2(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_log10(Float &out, const Float &op)
 {
+	Trace::Span span("log10", out.getPrecision());
 	return mpfr_log10(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_log1p(Float &out, const Float &op)
 {
+	Trace::Span span("log1p", out.getPrecision());
 	return mpfr_log1p(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_exp(Float &out, const Float &op)
 {
+	Trace::Span span("exp", out.getPrecision());
 	return mpfr_exp(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_exp2(Float &out, const Float &op)
 {
+	Trace::Span span("exp2", out.getPrecision());
 	return mpfr_exp2(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_exp10(Float &out, const Float &op)
 {
+	Trace::Span span("exp10", out.getPrecision());
 	return mpfr_exp10(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_expm1(Float &out, const Float &op)
 {
+	Trace::Span span("expm1", out.getPrecision());
 	return mpfr_expm1(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_pow(Float &out, const Float &op1, const Float &op2)
 {
+	Trace::Span span("pow", out.getPrecision());
 	return mpfr_pow(&out.wrapped, &op1.wrapped, &op2.wrapped, out.rounding);
 };
 
 int Float::op_pow_si(Float &out, const Float &op1, long op2)
 {
+	Trace::Span span("pow_si", out.getPrecision());
 	return mpfr_pow_si(&out.wrapped, &op1.wrapped, op2, out.rounding);
 };
 
 int Float::op_ui_pow_ui(Float &out, unsigned long op1, unsigned long op2)
 {
+	Trace::Span span("ui_pow_ui", out.getPrecision());
 	return mpfr_ui_pow_ui(&out.wrapped, op1, op2, out.rounding);
 };
 
 int Float::op_ui_pow(Float &out, unsigned long op1, const Float &op2)
 {
+	Trace::Span span("ui_pow", out.getPrecision());
 	return mpfr_ui_pow(&out.wrapped, op1, &op2.wrapped, out.rounding);
 };
 
 int Float::op_cos(Float &out, const Float &op)
 {
+	Trace::Span span("cos", out.getPrecision());
 	return mpfr_cos(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_sin(Float &out, const Float &op)
 {
+	Trace::Span span("sin", out.getPrecision());
 	return mpfr_sin(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_tan(Float &out, const Float &op)
 {
+	Trace::Span span("tan", out.getPrecision());
 	return mpfr_tan(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_sin_cos(Float &sop, Float &cop, const Float &op)
 {
+	Trace::Span span("sin_cos", sop.getPrecision());
 	return mpfr_sin_cos(&sop.wrapped, &cop.wrapped, &op.wrapped, sop.rounding);
 };
 
 int Float::op_sec(Float &out, const Float &op)
 {
+	Trace::Span span("sec", out.getPrecision());
 	return mpfr_sec(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_csc(Float &out, const Float &op)
 {
+	Trace::Span span("csc", out.getPrecision());
 	return mpfr_csc(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_cot(Float &out, const Float &op)
 {
+	Trace::Span span("cot", out.getPrecision());
 	return mpfr_cot(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_acos(Float &out, const Float &op)
 {
+	Trace::Span span("acos", out.getPrecision());
 	return mpfr_acos(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_asin(Float &out, const Float &op)
 {
+	Trace::Span span("asin", out.getPrecision());
 	return mpfr_asin(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_atan(Float &out, const Float &op)
 {
+	Trace::Span span("atan", out.getPrecision());
 	return mpfr_atan(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_atan2(Float &out, const Float &y, const Float &x)
 {
+	Trace::Span span("atan2", out.getPrecision());
 	return mpfr_atan2(&out.wrapped, &y.wrapped, &x.wrapped, out.rounding);
 };
 
 int Float::op_cosh(Float &out, const Float &op)
 {
+	Trace::Span span("cosh", out.getPrecision());
 	return mpfr_cosh(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_sinh(Float &out, const Float &op)
 {
+	Trace::Span span("sinh", out.getPrecision());
 	return mpfr_sinh(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_tanh(Float &out, const Float &op)
 {
+	Trace::Span span("tanh", out.getPrecision());
 	return mpfr_tanh(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_sinh_cosh(Float &sop, Float &cop, const Float &op)
 {
+	Trace::Span span("sinh_cosh", sop.getPrecision());
 	return mpfr_sinh_cosh(&sop.wrapped, &cop.wrapped, &op.wrapped, sop.rounding);
 };
 
 int Float::op_sech(Float &out, const Float &op)
 {
+	Trace::Span span("sech", out.getPrecision());
 	return mpfr_sech(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_csch(Float &out, const Float &op)
 {
+	Trace::Span span("csch", out.getPrecision());
 	return mpfr_csch(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_coth(Float &out, const Float &op)
 {
+	Trace::Span span("coth", out.getPrecision());
 	return mpfr_coth(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_acosh(Float &out, const Float &op)
 {
+	Trace::Span span("acosh", out.getPrecision());
 	return mpfr_acosh(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_asinh(Float &out, const Float &op)
 {
+	Trace::Span span("asinh", out.getPrecision());
 	return mpfr_asinh(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_atanh(Float &out, const Float &op)
 {
+	Trace::Span span("atanh", out.getPrecision());
 	return mpfr_atanh(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_eint(Float &out, const Float &op)
 {
+	Trace::Span span("eint", out.getPrecision());
 	return mpfr_eint(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_li2(Float &out, const Float &op)
 {
+	Trace::Span span("li2", out.getPrecision());
 	return mpfr_li2(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_gamma(Float &out, const Float &op)
 {
+	Trace::Span span("gamma", out.getPrecision());
 	return mpfr_gamma(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_gamma_inc(Float &out, const Float &op, const Float &op2)
 {
+	Trace::Span span("gamma_inc", out.getPrecision());
 	return mpfr_gamma_inc(&out.wrapped, &op.wrapped, &op2.wrapped, out.rounding);
 };
 
 int Float::op_lngamma(Float &out, const Float &op)
 {
+	Trace::Span span("lngamma", out.getPrecision());
 	return mpfr_lngamma(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_lgamma(Float &out, val signp, const Float &op)
 {
+	Trace::Span span("lgamma", out.getPrecision());
 	int _signp;
 	int *addr;
 
@@ -692,92 +1026,110 @@ int Float::op_lgamma(Float &out, val signp, const Float &op)
 
 int Float::op_digamma(Float &out, const Float &op)
 {
+	Trace::Span span("digamma", out.getPrecision());
 	return mpfr_digamma(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_beta(Float &out, const Float &op1, const Float &op2)
 {
+	Trace::Span span("beta", out.getPrecision());
 	return mpfr_beta(&out.wrapped, &op1.wrapped, &op2.wrapped, out.rounding);
 };
 
 int Float::op_zeta(Float &out, const Float &op)
 {
+	Trace::Span span("zeta", out.getPrecision());
 	return mpfr_zeta(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_zeta_ui(Float &out, unsigned long op)
 {
+	Trace::Span span("zeta_ui", out.getPrecision());
 	return mpfr_zeta_ui(&out.wrapped, op, out.rounding);
 };
 
 int Float::op_erf(Float &out, const Float &op)
 {
+	Trace::Span span("erf", out.getPrecision());
 	return mpfr_erf(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_erfc(Float &out, const Float &op)
 {
+	Trace::Span span("erfc", out.getPrecision());
 	return mpfr_erfc(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_j0(Float &out, const Float &op)
 {
+	Trace::Span span("j0", out.getPrecision());
 	return mpfr_j0(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_j1(Float &out, const Float &op)
 {
+	Trace::Span span("j1", out.getPrecision());
 	return mpfr_j1(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_jn(Float &out, long n, const Float &op)
 {
+	Trace::Span span("jn", out.getPrecision());
 	return mpfr_jn(&out.wrapped, n, &op.wrapped, out.rounding);
 };
 
 int Float::op_y0(Float &out, const Float &op)
 {
+	Trace::Span span("y0", out.getPrecision());
 	return mpfr_y0(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_y1(Float &out, const Float &op)
 {
+	Trace::Span span("y1", out.getPrecision());
 	return mpfr_y1(&out.wrapped, &op.wrapped, out.rounding);
 };
 
 int Float::op_yn(Float &out, long n, const Float &op)
 {
+	Trace::Span span("yn", out.getPrecision());
 	return mpfr_yn(&out.wrapped, n, &op.wrapped, out.rounding);
 };
 
 int Float::op_agm(Float &out, const Float &op1, const Float &op2)
 {
+	Trace::Span span("agm", out.getPrecision());
 	return mpfr_agm(&out.wrapped, &op1.wrapped, &op2.wrapped, out.rounding);
 };
 
 int Float::op_ai(Float &out, const Float &x)
 {
+	Trace::Span span("ai", out.getPrecision());
 	return mpfr_ai(&out.wrapped, &x.wrapped, out.rounding);
 };
 
 int Float::op_const_log2(Float &out)
 {
-	return mpfr_const_log2(&out.wrapped, out.rounding);
+	Trace::Span span("const_log2", out.getPrecision());
+	return Constants::evaluate("log2", &out.wrapped, out.rounding);
 };
 
 int Float::op_const_pi(Float &out)
 {
-	return mpfr_const_pi(&out.wrapped, out.rounding);
+	Trace::Span span("const_pi", out.getPrecision());
+	return Constants::evaluate("pi", &out.wrapped, out.rounding);
 };
 
 int Float::op_const_euler(Float &out)
 {
-	return mpfr_const_euler(&out.wrapped, out.rounding);
+	Trace::Span span("const_euler", out.getPrecision());
+	return Constants::evaluate("euler", &out.wrapped, out.rounding);
 };
 
 int Float::op_const_catalan(Float &out)
 {
-	return mpfr_const_catalan(&out.wrapped, out.rounding);
+	Trace::Span span("const_catalan", out.getPrecision());
+	return Constants::evaluate("catalan", &out.wrapped, out.rounding);
 };
 
 void Float::jsArrayToMpfrArray(val array, mpfr_ptr *out, int length)
@@ -789,7 +1141,14 @@ void Float::jsArrayToMpfrArray(val array, mpfr_ptr *out, int length)
 std::string Float::op_get_version(){ return std::string(mpfr_get_version()); }
 std::string Float::op_get_patches(){ return std::string(mpfr_get_patches()); }
 std::string Float::op_buildopt_tune_case(){ return std::string(mpfr_buildopt_tune_case()); }
-int Float::op_sqr(Float &out, const Float &op) { return mpfr_sqr(&out.wrapped, &op.wrapped, out.rounding); }
+int Float::op_sqr(Float &out, const Float &op)
+{
+	Trace::Span span("sqr", out.getPrecision());
+	int ternary;
+	if (FixedPrecision::mul(&out.wrapped, &op.wrapped, &op.wrapped, out.rounding, ternary))
+		return ternary;
+	return mpfr_sqr(&out.wrapped, &op.wrapped, out.rounding);
+}
 int Float::op_cmp(const Float &op1, const Float &op2) { return mpfr_cmp(&op1.wrapped, &op2.wrapped); }
 int Float::op_cmp_ui(const Float &op1, unsigned long int op2) { return mpfr_cmp_ui(&op1.wrapped, op2); }
 int Float::op_cmp_si(const Float &op1, long int op2) { return mpfr_cmp_si(&op1.wrapped, op2); }
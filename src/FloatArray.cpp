@@ -0,0 +1,263 @@
+#include <mpfr.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+#include "FloatArray.hpp"
+#include "Accumulator.hpp"
+#include "Memory.hpp"
+#include "Trace.hpp"
+
+FloatArray::FloatArray(size_t length, prec_t precision)
+{
+	if (!Memory::admit(precision, length))
+		precision = MPFR_PREC_MIN;
+	items.resize(length);
+	for (__mpfr_struct &x : items)
+		mpfr_init2(&x, precision);
+}
+
+FloatArray::FloatArray(const FloatArray &other) : items(other.items.size()), rounding(other.rounding)
+{
+	for (size_t i = 0; i < items.size(); i++)
+	{
+		mpfr_init2(&items[i], mpfr_get_prec(&other.items[i]));
+		mpfr_set(&items[i], &other.items[i], MPFR_RNDN);
+	}
+}
+
+FloatArray::FloatArray(FloatArray &&other) : items(std::move(other.items)), rounding(other.rounding)
+{
+	other.items.clear();
+}
+
+FloatArray::~FloatArray()
+{
+	for (__mpfr_struct &x : items)
+		mpfr_clear(&x);
+}
+
+FloatArray FloatArray::from(val array, prec_t precision)
+{
+	size_t length = array["length"].as<size_t>();
+	FloatArray out(length, precision);
+	if (Accumulator::isFloat64Array(array))
+	{
+		std::vector<double> copy;
+		const double *x = Accumulator::doubles(array, copy);
+		for (size_t i = 0; i < length; i++)
+			mpfr_set_d(&out.items[i], x[i], out.rounding);
+	}
+	else
+		for (size_t i = 0; i < length; i++)
+			out.set(i, array[i]);
+	return out;
+}
+
+FloatArray FloatArray::fromDoubleDouble(val pairs, prec_t precision)
+{
+	std::vector<double> copy;
+	const double *x = Accumulator::doubles(pairs, copy);
+	FloatArray out(pairs["length"].as<size_t>() / 2, precision);
+	// hi and lo held exactly, a single rounding in the addition
+	mpfr_t hi, lo;
+	mpfr_init2(hi, 53);
+	mpfr_init2(lo, 53);
+	for (size_t i = 0; i < out.items.size(); i++)
+	{
+		mpfr_set_d(hi, x[2 * i], MPFR_RNDN);
+		mpfr_set_d(lo, x[2 * i + 1], MPFR_RNDN);
+		mpfr_add(&out.items[i], hi, lo, out.rounding);
+	}
+	mpfr_clear(hi);
+	mpfr_clear(lo);
+	return out;
+}
+
+// fills count doubles of out, or of a new Float64Array when out is undefined
+static val exportDoubles(val out, size_t count, const std::function<void(double *)> &write)
+{
+	if (out.isUndefined())
+		out = val::global("Float64Array").new_(count);
+	if (out["length"].as<size_t>() < count)
+	{
+		std::cerr << "error: Float64Array of length " << out["length"].as<size_t>() << " cannot hold " << count << " doubles" << std::endl;
+		return out;
+	}
+	val memory = val(typed_memory_view(0, (const double *)nullptr))["buffer"];
+	if (out["buffer"].strictlyEquals(memory))
+	{
+		write((double *)out["byteOffset"].as<uintptr_t>());
+		return out;
+	}
+	std::vector<double> buffer(count);
+	write(buffer.data());
+	out.call<void>("set", val(typed_memory_view(count, buffer.data())));
+	return out;
+}
+
+val FloatArray::toFloat64Array() const { return toFloat64Array(val::undefined()); }
+val FloatArray::toFloat64Array(val out) const
+{
+	return exportDoubles(out, items.size(), [this](double *x) {
+		for (size_t i = 0; i < items.size(); i++)
+			x[i] = mpfr_get_d(&items[i], rounding);
+	});
+}
+
+val FloatArray::toDoubleDouble() const { return toDoubleDouble(val::undefined()); }
+val FloatArray::toDoubleDouble(val out) const
+{
+	return exportDoubles(out, 2 * items.size(), [this](double *x) {
+		mpfr_t rest;
+		mpfr_init2(rest, 64);
+		for (size_t i = 0; i < items.size(); i++)
+		{
+			mpfr_srcptr item = &items[i];
+			double hi = mpfr_get_d(item, MPFR_RNDN), lo = 0;
+			if (std::isfinite(hi) && mpfr_regular_p(item))
+			{
+				// x - hi is exact on the precision of x plus two bits
+				mpfr_set_prec(rest, std::max<prec_t>(mpfr_get_prec(item), 53) + 2);
+				mpfr_sub_d(rest, item, hi, MPFR_RNDN);
+				lo = mpfr_get_d(rest, MPFR_RNDN);
+			}
+			x[2 * i] = hi;
+			x[2 * i + 1] = lo;
+		}
+		mpfr_clear(rest);
+	});
+}
+
+size_t FloatArray::getLength() const { return items.size(); }
+int FloatArray::getRounding() const { return rounding; }
+FloatArray::builder_pattern FloatArray::setRounding(int mode) { rounding = static_cast<Float::rnd_t>(mode); }
+
+size_t FloatArray::size() const { return items.size(); }
+mpfr_ptr FloatArray::at(size_t i) { return &items[i]; }
+mpfr_srcptr FloatArray::at(size_t i) const { return &items[i]; }
+
+bool FloatArray::check(size_t i) const
+{
+	if (i < items.size())
+		return true;
+	std::cerr << "error: index " << i << " out of range of FloatArray of length " << items.size() << std::endl;
+	return false;
+}
+
+Float FloatArray::get(size_t i) const
+{
+	if (!check(i))
+		return Float(MPFR_PREC_MIN);
+	Float out(mpfr_get_prec(&items[i]));
+	mpfr_set(out.ptr(), &items[i], MPFR_RNDN);
+	return out;
+}
+
+FloatArray::builder_pattern FloatArray::set(size_t i, val v)
+{
+	if (!check(i))
+		return;
+	if (v.isNumber())
+		mpfr_set_d(&items[i], v.as<double>(), rounding);
+	else if (v.isString())
+		mpfr_set_str(&items[i], v.as<std::string>().c_str(), 10, rounding);
+	else
+		mpfr_set(&items[i], v.as<const Float &>().ptr(), rounding);
+}
+
+bool FloatArray::less(const __mpfr_struct &a, const __mpfr_struct &b)
+{
+	return !mpfr_total_order_p(&b, &a);
+}
+
+// precision of the first element, for the trace
+static FloatArray::prec_t precisionOf(const std::vector<__mpfr_struct> &items)
+{
+	return items.empty() ? 0 : mpfr_get_prec(&items[0]);
+}
+
+FloatArray::builder_pattern FloatArray::sort()
+{
+	Trace::Span span("FloatArray.sort", precisionOf(items));
+	std::sort(items.begin(), items.end(), less);
+}
+
+FloatArray::builder_pattern FloatArray::stableSort()
+{
+	Trace::Span span("FloatArray.stableSort", precisionOf(items));
+	std::stable_sort(items.begin(), items.end(), less);
+}
+
+// Uint32Array of the indices that sort the array, the array is unchanged
+val FloatArray::argsort(bool stable) const
+{
+	Trace::Span span("FloatArray.argsort", precisionOf(items));
+	std::vector<uint32_t> order(items.size());
+	std::iota(order.begin(), order.end(), 0);
+	auto cmp = [this](uint32_t a, uint32_t b) { return less(items[a], items[b]); };
+	if (stable)
+		std::stable_sort(order.begin(), order.end(), cmp);
+	else
+		std::sort(order.begin(), order.end(), cmp);
+	return val::global("Uint32Array").new_(typed_memory_view(order.size(), order.data()));
+}
+
+// binary searches, the array must be sorted
+int FloatArray::lowerBound(val v) const
+{
+	Float key(53);
+	const Float &x = v.isNumber() ? (key = v.as<double>()) : v.as<const Float &>();
+	return std::lower_bound(items.begin(), items.end(), *x.ptr(), less) - items.begin();
+}
+
+int FloatArray::upperBound(val v) const
+{
+	Float key(53);
+	const Float &x = v.isNumber() ? (key = v.as<double>()) : v.as<const Float &>();
+	return std::upper_bound(items.begin(), items.end(), *x.ptr(), less) - items.begin();
+}
+
+// NaNs are skipped like mpfr_min/mpfr_max, first index on ties,
+// -1 for an empty array and 0 when everything is NaN
+int FloatArray::extremum(int sign) const
+{
+	if (items.empty())
+		return -1;
+	int best = -1;
+	for (size_t i = 0; i < items.size(); i++)
+		if (!mpfr_nan_p(&items[i]) && (best < 0 || mpfr_cmp(&items[i], &items[best]) * sign < 0))
+			best = i;
+	return best < 0 ? 0 : best;
+}
+
+int FloatArray::argmin() const { return extremum(1); }
+int FloatArray::argmax() const { return extremum(-1); }
+
+Float FloatArray::min() const
+{
+	int i = argmin();
+	return i < 0 ? Float(MPFR_PREC_MIN) : get(i);
+}
+
+Float FloatArray::max() const
+{
+	int i = argmax();
+	return i < 0 ? Float(MPFR_PREC_MIN) : get(i);
+}
+
+// k-th smallest element, partially reorders the array around it
+Float FloatArray::select(size_t k)
+{
+	Trace::Span span("FloatArray.select", precisionOf(items));
+	if (!check(k))
+		return Float(MPFR_PREC_MIN);
+	std::nth_element(items.begin(), items.begin() + k, items.end(), less);
+	return get(k);
+}
@@ -0,0 +1,214 @@
+#include <mpfr.h>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+#include "FloatTable.hpp"
+#include "FloatArray.hpp"
+
+static const size_t MIN_CAPACITY = 16;
+
+static bool same(mpfr_srcptr a, mpfr_srcptr b)
+{
+	return mpfr_nan_p(a) ? mpfr_nan_p(b) : mpfr_equal_p(a, b);
+}
+
+FloatTable::FloatTable() : slots(MIN_CAPACITY, Slot{{}, 0, Empty}) {}
+
+FloatTable::~FloatTable()
+{
+	for (Slot &slot : slots)
+		if (slot.state == Full)
+			mpfr_clear(&slot.key);
+}
+
+val FloatTable::copyKeys() const
+{
+	val out = val::array();
+	for (const Slot &slot : slots)
+	{
+		if (slot.state != Full)
+			continue;
+		Float key(mpfr_get_prec(&slot.key));
+		mpfr_set(key.ptr(), &slot.key, MPFR_RNDN);
+		out.call<void>("push", key);
+	}
+	return out;
+}
+
+long FloatTable::find(mpfr_srcptr key) const
+{
+	uint32_t hash = Float::hash(key);
+	size_t mask = slots.size() - 1;
+	for (size_t i = hash & mask;; i = (i + 1) & mask)
+	{
+		const Slot &slot = slots[i];
+		if (slot.state == Empty)
+			return -1;
+		if (slot.state == Full && slot.hash == hash && same(&slot.key, key))
+			return i;
+	}
+}
+
+size_t FloatTable::insert(mpfr_srcptr key, bool &inserted)
+{
+	long found = find(key);
+	inserted = found < 0;
+	if (!inserted)
+		return found;
+	if (4 * (used + 1) > 3 * slots.size())
+		rehash(4 * (count + 1) > slots.size() ? 2 * slots.size() : slots.size());
+	uint32_t hash = Float::hash(key);
+	size_t mask = slots.size() - 1, i = hash & mask;
+	// the first tombstone on the way is reused
+	while (slots[i].state == Full)
+		i = (i + 1) & mask;
+	Slot &slot = slots[i];
+	used += slot.state == Empty;
+	count++;
+	mpfr_init2(&slot.key, mpfr_get_prec(key));
+	mpfr_set(&slot.key, key, MPFR_RNDN);
+	slot.hash = hash;
+	slot.state = Full;
+	return i;
+}
+
+long FloatTable::erase(mpfr_srcptr key)
+{
+	long found = find(key);
+	if (found < 0)
+		return -1;
+	mpfr_clear(&slots[found].key);
+	slots[found].state = Deleted;
+	count--;
+	return found;
+}
+
+void FloatTable::reset()
+{
+	for (Slot &slot : slots)
+		if (slot.state == Full)
+			mpfr_clear(&slot.key);
+	slots.assign(MIN_CAPACITY, Slot{{}, 0, Empty});
+	relocate(std::vector<long>(), MIN_CAPACITY);
+	count = used = 0;
+}
+
+void FloatTable::relocate(const std::vector<long> &, size_t) {}
+
+// the keys are moved as structs, their limbs stay in place
+void FloatTable::rehash(size_t capacity)
+{
+	std::vector<Slot> next(capacity, Slot{{}, 0, Empty});
+	std::vector<long> moves(slots.size(), -1);
+	size_t mask = capacity - 1;
+	for (size_t j = 0; j < slots.size(); j++)
+	{
+		if (slots[j].state != Full)
+			continue;
+		size_t i = slots[j].hash & mask;
+		while (next[i].state == Full)
+			i = (i + 1) & mask;
+		next[i] = slots[j];
+		moves[j] = i;
+	}
+	slots.swap(next);
+	used = count;
+	relocate(moves, capacity);
+}
+
+size_t FloatSet::getSize() const { return count; }
+
+bool FloatSet::add(const Float &key)
+{
+	bool inserted;
+	insert(key.ptr(), inserted);
+	return inserted;
+}
+
+int FloatSet::addAll(val keys)
+{
+	int added = 0;
+	bool inserted;
+	if (keys.instanceof(val::module_property("FloatArray")))
+	{
+		const FloatArray &array = keys.as<const FloatArray &>();
+		for (size_t i = 0; i < array.size(); i++)
+		{
+			insert(array.at(i), inserted);
+			added += inserted;
+		}
+		return added;
+	}
+	int length = keys["length"].as<int>();
+	for (int i = 0; i < length; i++)
+	{
+		insert(keys[i].as<const Float &>().ptr(), inserted);
+		added += inserted;
+	}
+	return added;
+}
+
+bool FloatSet::has(const Float &key) const { return find(key.ptr()) >= 0; }
+bool FloatSet::remove(const Float &key) { return erase(key.ptr()) >= 0; }
+FloatSet::builder_pattern FloatSet::clear() { reset(); }
+val FloatSet::values() const { return copyKeys(); }
+
+size_t FloatMap::getSize() const { return count; }
+
+FloatMap::builder_pattern FloatMap::set(const Float &key, val value)
+{
+	bool inserted;
+	size_t i = insert(key.ptr(), inserted);
+	if (values.size() != slots.size())
+		values.resize(slots.size(), val::undefined());
+	values[i] = value;
+}
+
+val FloatMap::get(const Float &key) const
+{
+	long i = find(key.ptr());
+	return i < 0 ? val::undefined() : values[i];
+}
+
+bool FloatMap::has(const Float &key) const { return find(key.ptr()) >= 0; }
+
+bool FloatMap::remove(const Float &key)
+{
+	long i = erase(key.ptr());
+	if (i < 0)
+		return false;
+	// drop the reference to the JS value
+	values[i] = val::undefined();
+	return true;
+}
+
+FloatMap::builder_pattern FloatMap::clear() { reset(); }
+val FloatMap::keys() const { return copyKeys(); }
+
+// [[key, value], ...]
+val FloatMap::entries() const
+{
+	val out = val::array();
+	for (size_t i = 0; i < slots.size(); i++)
+	{
+		if (slots[i].state != Full)
+			continue;
+		Float key(mpfr_get_prec(&slots[i].key));
+		mpfr_set(key.ptr(), &slots[i].key, MPFR_RNDN);
+		val entry = val::array();
+		entry.call<void>("push", key);
+		entry.call<void>("push", values[i]);
+		out.call<void>("push", entry);
+	}
+	return out;
+}
+
+void FloatMap::relocate(const std::vector<long> &moves, size_t capacity)
+{
+	std::vector<val> next(capacity, val::undefined());
+	for (size_t j = 0; j < moves.size() && j < values.size(); j++)
+		if (moves[j] >= 0)
+			next[moves[j]] = values[j];
+	values.swap(next);
+}
@@ -0,0 +1,497 @@
+#include <mpfr.h>
+#include <cctype>
+#include <cstring>
+#include <iostream>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+#include "Formula.hpp"
+#include "Constants.hpp"
+#include "Trace.hpp"
+
+const Formula::Function Formula::functions[] = {
+	{"sqrt", &Float::op_sqrt},
+	{"rec_sqrt", &Float::op_rec_sqrt},
+	{"cbrt", &Float::op_cbrt},
+	{"abs", &Float::op_abs},
+	{"exp", &Float::op_exp},
+	{"exp2", &Float::op_exp2},
+	{"exp10", &Float::op_exp10},
+	{"expm1", &Float::op_expm1},
+	{"log", &Float::op_log},
+	{"log2", &Float::op_log2},
+	{"log10", &Float::op_log10},
+	{"log1p", &Float::op_log1p},
+	{"sin", &Float::op_sin},
+	{"cos", &Float::op_cos},
+	{"tan", &Float::op_tan},
+	{"sec", &Float::op_sec},
+	{"csc", &Float::op_csc},
+	{"cot", &Float::op_cot},
+	{"asin", &Float::op_asin},
+	{"acos", &Float::op_acos},
+	{"atan", &Float::op_atan},
+	{"sinh", &Float::op_sinh},
+	{"cosh", &Float::op_cosh},
+	{"tanh", &Float::op_tanh},
+	{"sech", &Float::op_sech},
+	{"csch", &Float::op_csch},
+	{"coth", &Float::op_coth},
+	{"asinh", &Float::op_asinh},
+	{"acosh", &Float::op_acosh},
+	{"atanh", &Float::op_atanh},
+	{"eint", &Float::op_eint},
+	{"li2", &Float::op_li2},
+	{"gamma", &Float::op_gamma},
+	{"lngamma", &Float::op_lngamma},
+	{"digamma", &Float::op_digamma},
+	{"zeta", &Float::op_zeta},
+	{"erf", &Float::op_erf},
+	{"erfc", &Float::op_erfc},
+	{"j0", &Float::op_j0},
+	{"j1", &Float::op_j1},
+	{"y0", &Float::op_y0},
+	{"y1", &Float::op_y1},
+	{"ai", &Float::op_ai},
+	{"floor", &Float::op_floor},
+	{"ceil", &Float::op_ceil},
+	{"trunc", &Float::op_trunc},
+	{"frac", &Float::op_frac},
+	{nullptr, nullptr}};
+
+const Formula::Function2 Formula::functions2[] = {
+	{"pow", &mpfr_pow},
+	{"atan2", &mpfr_atan2},
+	{"hypot", &mpfr_hypot},
+	{"min", &mpfr_min},
+	{"max", &mpfr_max},
+	{"agm", &mpfr_agm},
+	{"fmod", &mpfr_fmod},
+	{nullptr, nullptr}};
+
+// recursive descent, emits the tape while parsing
+//   expr    := term (('+' | '-') term)*
+//   term    := unary (('*' | '/') unary)*
+//   unary   := ('-' | '+') unary | power
+//   power   := primary ('^' unary)?
+//   primary := number | name | name '(' expr (',' expr)? ')' | '(' expr ')'
+struct FormulaParser
+{
+	Formula &f;
+	const std::string &s;
+	size_t pos = 0;
+	int depth = 0;
+
+	FormulaParser(Formula &f, const std::string &s) : f(f), s(s) {}
+
+	bool fail(const std::string &message)
+	{
+		if (f.error.empty())
+			f.error = message + " at " + std::to_string(pos);
+		return false;
+	}
+
+	void emit(Formula::Op op, long arg)
+	{
+		int slot;
+		switch (op)
+		{
+		case Formula::Variable:
+		case Formula::Constant:
+			slot = depth++;
+			if (depth > f.depth)
+				f.depth = depth;
+			break;
+		case Formula::Neg:
+		case Formula::PowInt:
+		case Formula::Call:
+			slot = depth - 1;
+			break;
+		default:
+			slot = --depth - 1;
+		}
+		f.tape.push_back({op, slot, arg});
+	}
+
+	char peek()
+	{
+		while (pos < s.size() && std::isspace((unsigned char)s[pos]))
+			pos++;
+		return pos < s.size() ? s[pos] : 0;
+	}
+
+	bool accept(char c)
+	{
+		if (peek() != c)
+			return false;
+		pos++;
+		return true;
+	}
+
+	bool expr()
+	{
+		if (!term())
+			return false;
+		for (char c = peek(); c == '+' || c == '-'; c = peek())
+		{
+			pos++;
+			if (!term())
+				return false;
+			emit(c == '+' ? Formula::Add : Formula::Sub, 0);
+		}
+		return true;
+	}
+
+	bool term()
+	{
+		if (!unary())
+			return false;
+		for (char c = peek(); c == '*' || c == '/'; c = peek())
+		{
+			pos++;
+			if (!unary())
+				return false;
+			emit(c == '*' ? Formula::Mul : Formula::Div, 0);
+		}
+		return true;
+	}
+
+	bool unary()
+	{
+		if (accept('+'))
+			return unary();
+		if (accept('-'))
+		{
+			if (!unary())
+				return false;
+			emit(Formula::Neg, 0);
+			return true;
+		}
+		return power();
+	}
+
+	// small integer exponents are folded into PowInt
+	bool power()
+	{
+		if (!primary())
+			return false;
+		if (!accept('^'))
+			return true;
+		size_t start = f.tape.size();
+		if (!unary())
+			return false;
+		size_t length = f.tape.size() - start;
+		const Formula::Instruction &first = f.tape[start];
+		bool negative = length == 2 && f.tape[start + 1].op == Formula::Neg;
+		if (first.op == Formula::Constant && (length == 1 || negative))
+		{
+			const std::string &literal = f.literals[first.arg];
+			if (!literal.empty() && literal.size() <= 9 && std::strspn(literal.c_str(), "0123456789") == literal.size())
+			{
+				long n = std::stol(literal);
+				f.tape.resize(start);
+				depth--;
+				emit(Formula::PowInt, negative ? -n : n);
+				return true;
+			}
+		}
+		emit(Formula::Pow, 0);
+		return true;
+	}
+
+	bool primary()
+	{
+		char c = peek();
+		if (c == '(')
+		{
+			pos++;
+			if (!expr())
+				return false;
+			return accept(')') || fail("expected )");
+		}
+		if (std::isdigit((unsigned char)c) || c == '.')
+			return number();
+		if (std::isalpha((unsigned char)c) || c == '_')
+		{
+			size_t start = pos;
+			while (pos < s.size() && (std::isalnum((unsigned char)s[pos]) || s[pos] == '_'))
+				pos++;
+			std::string name = s.substr(start, pos - start);
+			if (peek() == '(')
+				return call(name);
+			for (size_t i = 0; i < f.variables.size(); i++)
+				if (f.variables[i] == name)
+				{
+					emit(Formula::Variable, i);
+					return true;
+				}
+			if (name == "pi" || name == "e")
+			{
+				f.literals.push_back(name);
+				emit(Formula::Constant, f.literals.size() - 1);
+				return true;
+			}
+			pos = start;
+			return fail("unknown name " + name);
+		}
+		return fail(c ? std::string("unexpected ") + c : "unexpected end");
+	}
+
+	bool number()
+	{
+		size_t start = pos;
+		while (pos < s.size() && (std::isdigit((unsigned char)s[pos]) || s[pos] == '.'))
+			pos++;
+		// exponent only when digits follow
+		if (pos < s.size() && (s[pos] == 'e' || s[pos] == 'E'))
+		{
+			size_t p = pos + 1;
+			if (p < s.size() && (s[p] == '+' || s[p] == '-'))
+				p++;
+			if (p < s.size() && std::isdigit((unsigned char)s[p]))
+			{
+				pos = p;
+				while (pos < s.size() && std::isdigit((unsigned char)s[pos]))
+					pos++;
+			}
+		}
+		f.literals.push_back(s.substr(start, pos - start));
+		emit(Formula::Constant, f.literals.size() - 1);
+		return true;
+	}
+
+	bool call(const std::string &name)
+	{
+		pos++;
+		for (int i = 0; Formula::functions[i].name; i++)
+			if (name == Formula::functions[i].name)
+			{
+				if (!expr())
+					return false;
+				emit(Formula::Call, i);
+				return accept(')') || fail("expected )");
+			}
+		for (int i = 0; Formula::functions2[i].name; i++)
+			if (name == Formula::functions2[i].name)
+			{
+				if (!expr())
+					return false;
+				if (!accept(','))
+					return fail("expected ,");
+				if (!expr())
+					return false;
+				emit(Formula::Call2, i);
+				return accept(')') || fail("expected )");
+			}
+		return fail("unknown function " + name);
+	}
+};
+
+Formula::Formula(const std::string &source, val variables)
+{
+	int length = variables["length"].as<int>();
+	for (int i = 0; i < length; i++)
+		this->variables.push_back(variables[i].as<std::string>());
+	compile(source);
+}
+
+Formula::Formula(const std::string &source, const std::vector<std::string> &variables)
+	: variables(variables)
+{
+	compile(source);
+}
+
+void Formula::compile(const std::string &source)
+{
+	FormulaParser parser(*this, source);
+	if (parser.expr() && parser.peek())
+		parser.fail("unexpected " + std::string(1, parser.peek()));
+	if (!error.empty())
+	{
+		std::cerr << "error: formula " << error << std::endl;
+		tape.clear();
+	}
+}
+
+bool Formula::isValid() const { return error.empty(); }
+std::string Formula::getError() const { return error; }
+int Formula::getVariableCount() const { return variables.size(); }
+const std::vector<Formula::Instruction> &Formula::getTape() const { return tape; }
+int Formula::getDepth() const { return depth; }
+
+void Formula::constant(int index, mpfr_ptr out) const
+{
+	const std::string &literal = literals[index];
+	if (literal == "pi" || literal == "e")
+		Constants::evaluate(literal, out, MPFR_RNDN);
+	else
+		mpfr_set_str(out, literal.c_str(), 10, MPFR_RNDN);
+}
+
+// registers and constants at the evaluation precision, kept until it changes
+void Formula::prepare(prec_t precision)
+{
+	if (precision == prepared)
+		return;
+	prepared = precision;
+	stack.clear();
+	constants.clear();
+	for (int i = 0; i < depth; i++)
+		stack.emplace_back(precision);
+	for (size_t i = 0; i < literals.size(); i++)
+	{
+		constants.emplace_back(precision);
+		constant(i, constants.back().ptr());
+	}
+}
+
+int Formula::evaluate(mpfr_srcptr const *args, mpfr_ptr out, mpfr_rnd_t rnd, const prec_t *precisions)
+{
+	if (tape.empty())
+	{
+		mpfr_set_nan(out);
+		return 0;
+	}
+	prepare(mpfr_get_prec(out));
+	for (size_t k = 0; k < tape.size(); k++)
+	{
+		const Instruction &ins = tape[k];
+		mpfr_ptr r = stack[ins.slot].ptr();
+		mpfr_srcptr b = ins.slot + 1 < depth ? stack[ins.slot + 1].ptr() : nullptr;
+		switch (ins.op)
+		{
+		case Variable:
+			mpfr_set(r, args[ins.arg], MPFR_RNDN);
+			break;
+		case Constant:
+			mpfr_set(r, constants[ins.arg].ptr(), MPFR_RNDN);
+			break;
+		case Neg:
+			mpfr_neg(r, r, MPFR_RNDN);
+			break;
+		case Add:
+			mpfr_add(r, r, b, MPFR_RNDN);
+			break;
+		case Sub:
+			mpfr_sub(r, r, b, MPFR_RNDN);
+			break;
+		case Mul:
+			mpfr_mul(r, r, b, MPFR_RNDN);
+			break;
+		case Div:
+			mpfr_div(r, r, b, MPFR_RNDN);
+			break;
+		case Pow:
+			mpfr_pow(r, r, b, MPFR_RNDN);
+			break;
+		case PowInt:
+			mpfr_pow_si(r, r, ins.arg, MPFR_RNDN);
+			break;
+		case Call:
+			functions[ins.arg].fn(stack[ins.slot], stack[ins.slot]);
+			break;
+		case Call2:
+			functions2[ins.arg].fn(r, r, b, MPFR_RNDN);
+			break;
+		}
+		// down and back up, the second rounding is exact
+		if (precisions && precisions[k] < prepared)
+		{
+			mpfr_prec_round(r, precisions[k], MPFR_RNDN);
+			mpfr_prec_round(r, prepared, MPFR_RNDN);
+		}
+	}
+	return mpfr_set(out, stack[0].ptr(), rnd);
+}
+
+std::vector<mpfr_srcptr> Formula::arguments(val args, std::vector<Float> &holder)
+{
+	int length = args["length"].as<int>();
+	holder.reserve(length);
+	std::vector<mpfr_srcptr> ptrs(length);
+	for (int i = 0; i < length; i++)
+	{
+		val v = args[i];
+		if (v.isNumber())
+		{
+			holder.emplace_back(53, v.as<double>());
+			ptrs[i] = holder.back().ptr();
+		}
+		else
+			ptrs[i] = v.as<const Float &>().ptr();
+	}
+	return ptrs;
+}
+
+int Formula::evaluate(Float &out, val args)
+{
+	std::vector<Float> numbers;
+	std::vector<mpfr_srcptr> ptrs = arguments(args, numbers);
+	if (ptrs.size() != variables.size())
+	{
+		std::cerr << "error: formula expects " << variables.size() << " arguments, got " << ptrs.size() << std::endl;
+		return 0;
+	}
+	return evaluate(ptrs.data(), out.ptr(), (mpfr_rnd_t)out.getRounding());
+}
+
+std::string Formula::describe(size_t index) const
+{
+	const Instruction &ins = tape[index];
+	static const char *names[] = {"", "", "neg", "add", "sub", "mul", "div", "pow"};
+	switch (ins.op)
+	{
+	case Variable:
+		return variables[ins.arg];
+	case Constant:
+		return literals[ins.arg];
+	case PowInt:
+		return "^" + std::to_string(ins.arg);
+	case Call:
+		return functions[ins.arg].name;
+	case Call2:
+		return functions2[ins.arg].name;
+	default:
+		return names[ins.op];
+	}
+}
+
+Formula::builder_pattern Formula::evaluateBatch(val columns, FloatArray &out)
+{
+	batch(columns, out, (mpfr_rnd_t)out.getRounding());
+}
+
+Formula::builder_pattern Formula::evaluateBatch(val columns, FloatArray &out, Context &context)
+{
+	Context::Scope scope(context);
+	batch(columns, out, (mpfr_rnd_t)context.getRounding());
+}
+
+void Formula::batch(val columns, FloatArray &out, mpfr_rnd_t rnd)
+{
+	Trace::Span span("Formula.evaluateBatch", out.size() ? mpfr_get_prec(out.at(0)) : 0);
+	int count = columns["length"].as<int>();
+	if (count != (int)variables.size())
+	{
+		std::cerr << "error: formula expects " << variables.size() << " columns, got " << count << std::endl;
+		return;
+	}
+	std::vector<FloatArray *> inputs(count);
+	for (int j = 0; j < count; j++)
+	{
+		inputs[j] = &columns[j].as<FloatArray &>();
+		if (inputs[j]->size() != out.size())
+		{
+			std::cerr << "error: formula columns and output of different size" << std::endl;
+			return;
+		}
+	}
+	std::vector<mpfr_srcptr> args(count);
+	for (size_t i = 0; i < out.size(); i++)
+	{
+		for (int j = 0; j < count; j++)
+			args[j] = inputs[j]->at(i);
+		evaluate(args.data(), out.at(i), rnd);
+	}
+}
@@ -0,0 +1,619 @@
+#include <mpfr.h>
+#include <gmp.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+#include "IntegerRelation.hpp"
+#include "FloatArray.hpp"
+#include "Trace.hpp"
+
+typedef IntegerRelation::prec_t prec_t;
+
+// precision of the low level of pslq, and size of the integer entries at
+// which it hands over to the full precision level
+static const prec_t LOW = 128;
+static const size_t LEVEL_BITS = 48;
+// bits of margin when telling a relation from rounding noise
+static const long MARGIN = 32;
+// a relation has to stand out from the noise: in pslq min |y| drops by
+// that many bits when it is found (Bailey's criterion), noise drops by
+// about LEVEL_BITS per level; in lll its norm is below the bound on the
+// independent relations by GAP bits, noise gives close norms
+static const long DROP = LEVEL_BITS + MARGIN;
+static const long GAP = MARGIN / 2;
+
+// rows x cols GMP integers, zero or the identity
+struct Integers
+{
+	size_t rows, cols;
+	std::vector<__mpz_struct> a;
+
+	Integers(size_t rows, size_t cols, bool identity = false) : rows(rows), cols(cols), a(rows * cols)
+	{
+		for (size_t i = 0; i < a.size(); i++)
+			mpz_init_set_ui(&a[i], identity && i % (cols + 1) == 0);
+	}
+	Integers(const Integers &) = delete;
+	Integers &operator=(const Integers &) = delete;
+	~Integers()
+	{
+		for (__mpz_struct &z : a)
+			mpz_clear(&z);
+	}
+
+	mpz_ptr operator()(size_t i, size_t j) { return &a[i * cols + j]; }
+	mpz_srcptr operator()(size_t i, size_t j) const { return &a[i * cols + j]; }
+
+	size_t bits() const
+	{
+		size_t out = 0;
+		for (const __mpz_struct &z : a)
+			out = std::max(out, mpz_sizeinbase(&z, 2));
+		return out;
+	}
+
+	// this = left right
+	void product(const Integers &left, const Integers &right)
+	{
+		for (size_t i = 0; i < rows; i++)
+			for (size_t j = 0; j < cols; j++)
+			{
+				mpz_set_ui((*this)(i, j), 0);
+				for (size_t k = 0; k < left.cols; k++)
+					mpz_addmul((*this)(i, j), left(i, k), right(k, j));
+			}
+	}
+};
+
+// state of one PSLQ level, y is empty on the low level where only H drives
+// the iteration
+struct Level
+{
+	size_t n;
+	prec_t precision;
+	std::vector<Float> y;
+	// n rows of n - 1
+	std::vector<Float> H;
+	Integers A, B;
+	Float t0, t1, t2, t3, t4;
+	__mpz_struct q;
+
+	Level(size_t n, prec_t precision)
+		: n(n), precision(precision), H(n * (n - 1), Float(precision, 0)), A(n, n, true), B(n, n, true),
+		  t0(precision), t1(precision), t2(precision), t3(precision), t4(precision)
+	{
+		mpz_init(&q);
+	}
+	Level(const Level &) = delete;
+	Level &operator=(const Level &) = delete;
+	~Level() { mpz_clear(&q); }
+
+	mpfr_ptr h(size_t i, size_t j) { return H[i * (n - 1) + j].ptr(); }
+};
+
+// out = sum c_k v_k with a single rounding, the products being exact
+static void combine(mpfr_ptr out, const std::vector<mpfr_srcptr> &v, const std::vector<mpz_srcptr> &c)
+{
+	std::vector<Float> products;
+	std::vector<mpfr_ptr> terms;
+	products.reserve(v.size());
+	for (size_t k = 0; k < v.size(); k++)
+	{
+		products.emplace_back(mpfr_get_prec(v[k]) + mpz_sizeinbase(c[k], 2));
+		mpfr_mul_z(products.back().ptr(), v[k], c[k], MPFR_RNDN);
+		terms.push_back(products.back().ptr());
+	}
+	mpfr_sum(out, terms.data(), terms.size(), MPFR_RNDN);
+}
+
+// Hermite reduction of the rows from on, from column min(i - 1, limit) down
+static void reduce(Level &L, size_t from, size_t limit)
+{
+	for (size_t i = from; i < L.n; i++)
+		for (size_t j = std::min(i - 1, limit) + 1; j-- > 0;)
+		{
+			if (mpfr_zero_p(L.h(j, j)))
+				continue;
+			mpfr_div(L.t0.ptr(), L.h(i, j), L.h(j, j), MPFR_RNDN);
+			if (!mpfr_number_p(L.t0.ptr()))
+				continue;
+			mpfr_get_z(&L.q, L.t0.ptr(), MPFR_RNDN);
+			if (!mpz_sgn(&L.q))
+				continue;
+			if (!L.y.empty())
+			{
+				mpfr_mul_z(L.t1.ptr(), L.y[i].ptr(), &L.q, MPFR_RNDN);
+				mpfr_add(L.y[j].ptr(), L.y[j].ptr(), L.t1.ptr(), MPFR_RNDN);
+			}
+			for (size_t k = 0; k <= j; k++)
+			{
+				mpfr_mul_z(L.t1.ptr(), L.h(j, k), &L.q, MPFR_RNDN);
+				mpfr_sub(L.h(i, k), L.h(i, k), L.t1.ptr(), MPFR_RNDN);
+			}
+			for (size_t k = 0; k < L.n; k++)
+			{
+				mpz_submul(L.A(i, k), &L.q, L.A(j, k));
+				mpz_addmul(L.B(k, j), &L.q, L.B(k, i));
+			}
+		}
+}
+
+// one PSLQ iteration: exchange at the largest gamma^i |H_ii|, corner
+// rotation, reduction
+static void step(Level &L)
+{
+	static const double gamma = std::sqrt(4.0 / 3);
+	size_t n = L.n, m = 0;
+	double weight = gamma;
+	mpfr_mul_d(L.t1.ptr(), L.h(0, 0), weight, MPFR_RNDN);
+	for (size_t i = 1; i + 1 < n; i++)
+	{
+		weight *= gamma;
+		mpfr_mul_d(L.t0.ptr(), L.h(i, i), weight, MPFR_RNDN);
+		if (mpfr_cmpabs(L.t0.ptr(), L.t1.ptr()) > 0)
+		{
+			mpfr_swap(L.t0.ptr(), L.t1.ptr());
+			m = i;
+		}
+	}
+
+	if (!L.y.empty())
+		mpfr_swap(L.y[m].ptr(), L.y[m + 1].ptr());
+	for (size_t k = 0; k + 1 < n; k++)
+		mpfr_swap(L.h(m, k), L.h(m + 1, k));
+	for (size_t k = 0; k < n; k++)
+	{
+		mpz_swap(L.A(m, k), L.A(m + 1, k));
+		mpz_swap(L.B(k, m), L.B(k, m + 1));
+	}
+
+	if (m + 2 < n && !(mpfr_zero_p(L.h(m, m)) && mpfr_zero_p(L.h(m, m + 1))))
+	{
+		mpfr_hypot(L.t0.ptr(), L.h(m, m), L.h(m, m + 1), MPFR_RNDN);
+		mpfr_div(L.t1.ptr(), L.h(m, m), L.t0.ptr(), MPFR_RNDN);
+		mpfr_div(L.t2.ptr(), L.h(m, m + 1), L.t0.ptr(), MPFR_RNDN);
+		for (size_t i = m; i < n; i++)
+		{
+			mpfr_set(L.t3.ptr(), L.h(i, m), MPFR_RNDN);
+			mpfr_set(L.t4.ptr(), L.h(i, m + 1), MPFR_RNDN);
+			mpfr_fmma(L.h(i, m), L.t1.ptr(), L.t3.ptr(), L.t2.ptr(), L.t4.ptr(), MPFR_RNDN);
+			mpfr_fmms(L.h(i, m + 1), L.t1.ptr(), L.t4.ptr(), L.t2.ptr(), L.t3.ptr(), MPFR_RNDN);
+		}
+	}
+	reduce(L, m + 1, m + 1);
+}
+
+// H = L Q with L lower trapezoidal, by rotations of the columns
+static void lq(Level &L)
+{
+	size_t n = L.n;
+	for (size_t i = 0; i + 1 < n; i++)
+		for (size_t j = i + 1; j + 1 < n; j++)
+		{
+			if (mpfr_zero_p(L.h(i, j)))
+				continue;
+			mpfr_hypot(L.t0.ptr(), L.h(i, i), L.h(i, j), MPFR_RNDN);
+			mpfr_div(L.t1.ptr(), L.h(i, i), L.t0.ptr(), MPFR_RNDN);
+			mpfr_div(L.t2.ptr(), L.h(i, j), L.t0.ptr(), MPFR_RNDN);
+			for (size_t k = i; k < n; k++)
+			{
+				mpfr_set(L.t3.ptr(), L.h(k, i), MPFR_RNDN);
+				mpfr_set(L.t4.ptr(), L.h(k, j), MPFR_RNDN);
+				mpfr_fmma(L.h(k, i), L.t1.ptr(), L.t3.ptr(), L.t2.ptr(), L.t4.ptr(), MPFR_RNDN);
+				mpfr_fmms(L.h(k, j), L.t1.ptr(), L.t4.ptr(), L.t2.ptr(), L.t3.ptr(), MPFR_RNDN);
+			}
+			mpfr_set_zero(L.h(i, j), 1);
+		}
+}
+
+// applies the transformations of the low level to the full level:
+// y = y B, H = lq(A H), A = A_low A, B = B B_low
+static void update(Level &full, const Level &low)
+{
+	size_t n = full.n;
+	std::vector<Float> y(n, Float(full.precision));
+	std::vector<mpfr_srcptr> v(n);
+	std::vector<mpz_srcptr> c(n);
+	for (size_t j = 0; j < n; j++)
+	{
+		for (size_t k = 0; k < n; k++)
+		{
+			v[k] = full.y[k].ptr();
+			c[k] = low.B(k, j);
+		}
+		combine(y[j].ptr(), v, c);
+	}
+	full.y.swap(y);
+
+	std::vector<Float> H(full.H.size(), Float(full.precision));
+	for (size_t i = 0; i < n; i++)
+		for (size_t j = 0; j + 1 < n; j++)
+		{
+			for (size_t k = 0; k < n; k++)
+			{
+				v[k] = full.h(k, j);
+				c[k] = low.A(i, k);
+			}
+			combine(H[i * (n - 1) + j].ptr(), v, c);
+		}
+	full.H.swap(H);
+	lq(full);
+
+	Integers A(n, n), B(n, n);
+	A.product(low.A, full.A);
+	B.product(full.B, low.B);
+	std::swap(full.A.a, A.a);
+	std::swap(full.B.a, B.a);
+}
+
+// a.x vanishing to the precision (r relative to 2^scale) is a relation
+// only while the n coefficients hold fewer bits than the precision, beyond
+// that small combinations exist for any x
+static bool vanishes(mpfr_srcptr r, mpfr_exp_t scale, long bits, size_t n, prec_t precision)
+{
+	if ((long)n * bits + MARGIN > (long)precision)
+		return false;
+	return mpfr_zero_p(r) || mpfr_get_exp(r) - scale < bits + MARGIN - (long)precision;
+}
+
+static long columnBits(const Integers &B, size_t j)
+{
+	long out = 0;
+	for (size_t i = 0; i < B.rows; i++)
+		out = std::max<long>(out, mpz_sizeinbase(B(i, j), 2));
+	return out;
+}
+
+// FloatArray copied at the working precision, or converted
+static FloatArray inputs(val x, prec_t precision)
+{
+	if (!x.instanceof(val::module_property("FloatArray")))
+		return FloatArray::from(x, precision);
+	const FloatArray &source = x.as<const FloatArray &>();
+	FloatArray out(source.size(), precision);
+	for (size_t i = 0; i < source.size(); i++)
+		mpfr_set(out.at(i), source.at(i), MPFR_RNDN);
+	return out;
+}
+
+static bool finite(const FloatArray &x)
+{
+	if (x.size() < 2)
+	{
+		std::cerr << "error: integer relation of less than 2 numbers" << std::endl;
+		return false;
+	}
+	for (size_t i = 0; i < x.size(); i++)
+		if (!mpfr_number_p(x.at(i)))
+		{
+			std::cerr << "error: integer relation of NaN or infinity" << std::endl;
+			return false;
+		}
+	return true;
+}
+
+IntegerRelation::IntegerRelation(prec_t precision) : precision(precision) {}
+
+IntegerRelation::prec_t IntegerRelation::getPrecision() const { return precision; }
+IntegerRelation::builder_pattern IntegerRelation::setPrecision(prec_t precision) { this->precision = precision; }
+int IntegerRelation::getMaxIterations() const { return maxIterations; }
+IntegerRelation::builder_pattern IntegerRelation::setMaxIterations(int n) { maxIterations = n; }
+
+int IntegerRelation::getIterations() const { return iterations; }
+bool IntegerRelation::isFound() const { return found; }
+Float IntegerRelation::getBound() const { return bound; }
+Float IntegerRelation::getResidual() const { return residual; }
+
+// BigInts with the first nonzero coefficient positive, and the residual
+val IntegerRelation::relation(const std::vector<mpz_srcptr> &a, const std::vector<mpfr_srcptr> &x)
+{
+	combine(residual.ptr(), x, a);
+	mpfr_abs(residual.ptr(), residual.ptr(), MPFR_RNDN);
+	int sign = 0;
+	for (size_t i = 0; i < a.size() && !sign; i++)
+		sign = mpz_sgn(a[i]);
+	val BigInt = val::global("BigInt");
+	val out = val::array();
+	mpz_t c;
+	mpz_init(c);
+	for (size_t i = 0; i < a.size(); i++)
+	{
+		if (sign < 0)
+			mpz_neg(c, a[i]);
+		else
+			mpz_set(c, a[i]);
+		std::string digits(mpz_sizeinbase(c, 10) + 2, '\0');
+		mpz_get_str(&digits[0], 10, c);
+		out.call<void>("push", BigInt(std::string(digits.c_str())));
+	}
+	mpz_clear(c);
+	return out;
+}
+
+val IntegerRelation::pslq(val x)
+{
+	Trace::Span span("IntegerRelation.pslq", precision);
+	iterations = 0;
+	found = false;
+	mpfr_set_zero(bound.ptr(), 1);
+	mpfr_set_nan(residual.ptr());
+	FloatArray xs = inputs(x, precision);
+	if (!finite(xs))
+		return val::array();
+	size_t n = xs.size();
+	std::vector<mpfr_srcptr> v(n);
+	for (size_t i = 0; i < n; i++)
+		v[i] = xs.at(i);
+
+	// a zero is a relation by itself, and PSLQ needs nonzero inputs
+	for (size_t i = 0; i < n; i++)
+		if (mpfr_zero_p(v[i]))
+		{
+			Integers e(n, n, true);
+			std::vector<mpz_srcptr> a(n);
+			for (size_t k = 0; k < n; k++)
+				a[k] = e(i, k);
+			found = true;
+			mpfr_set_inf(bound.ptr(), 1);
+			return relation(a, v);
+		}
+
+	// y = x / |x|, s_j = |(y_j ... y_n)|,
+	// H_ii = s_i+1 / s_i, H_ij = -y_i y_j / (s_j s_j+1) below the diagonal
+	Level full(n, precision);
+	std::vector<Float> s(n + 1, Float(precision, 0));
+	for (size_t i = 0; i < n; i++)
+		full.y.emplace_back(precision);
+	for (size_t j = n; j-- > 0;)
+	{
+		mpfr_sqr(full.t0.ptr(), v[j], MPFR_RNDN);
+		mpfr_add(s[j].ptr(), s[j + 1].ptr(), full.t0.ptr(), MPFR_RNDN);
+	}
+	mpfr_sqrt(full.t0.ptr(), s[0].ptr(), MPFR_RNDN);
+	for (size_t j = 0; j < n; j++)
+	{
+		mpfr_div(full.y[j].ptr(), v[j], full.t0.ptr(), MPFR_RNDN);
+		mpfr_sqrt(s[j].ptr(), s[j].ptr(), MPFR_RNDN);
+		mpfr_div(s[j].ptr(), s[j].ptr(), full.t0.ptr(), MPFR_RNDN);
+	}
+	for (size_t i = 0; i < n; i++)
+		for (size_t j = 0; j + 1 < n && j <= i; j++)
+			if (i == j)
+				mpfr_div(full.h(i, i), s[i + 1].ptr(), s[i].ptr(), MPFR_RNDN);
+			else
+			{
+				mpfr_mul(full.t0.ptr(), full.y[i].ptr(), full.y[j].ptr(), MPFR_RNDN);
+				mpfr_mul(full.t1.ptr(), s[j].ptr(), s[j + 1].ptr(), MPFR_RNDN);
+				mpfr_div(full.h(i, j), full.t0.ptr(), full.t1.ptr(), MPFR_RNDN);
+				mpfr_neg(full.h(i, j), full.h(i, j), MPFR_RNDN);
+			}
+	reduce(full, 1, n);
+
+	bool levels = precision > LOW + 64;
+	size_t relationIndex = n;
+	// exponent of min |y| at the previous check, |y| = 1 at the start
+	mpfr_exp_t previous = 1;
+	while (iterations < maxIterations)
+	{
+		int steps = 0;
+		if (levels)
+		{
+			Level low(n, LOW);
+			bool singular = false;
+			for (size_t i = 0; i < full.H.size(); i++)
+				mpfr_set(low.H[i].ptr(), full.H[i].ptr(), MPFR_RNDN);
+			while (iterations < maxIterations && !singular && low.A.bits() <= LEVEL_BITS && low.B.bits() <= LEVEL_BITS)
+			{
+				step(low);
+				iterations++;
+				steps++;
+				for (size_t i = 0; i + 1 < n; i++)
+					singular |= mpfr_zero_p(low.h(i, i));
+			}
+			if (steps)
+			{
+				update(full, low);
+				reduce(full, 1, n);
+			}
+		}
+		// the low level is out of precision right away near a relation
+		if (!steps)
+		{
+			step(full);
+			iterations++;
+		}
+
+		size_t k = 0;
+		for (size_t i = 1; i < n; i++)
+			if (mpfr_cmpabs(full.y[i].ptr(), full.y[k].ptr()) < 0)
+				k = i;
+		// y = x B / |x|
+		bool zero = mpfr_zero_p(full.y[k].ptr());
+		mpfr_exp_t exponent = zero ? previous : mpfr_get_exp(full.y[k].ptr());
+		if (vanishes(full.y[k].ptr(), 0, columnBits(full.B, k), n, precision) && (zero || previous - exponent >= DROP))
+		{
+			relationIndex = k;
+			break;
+		}
+		previous = exponent;
+		// out of precision once every column of B is too large to be told
+		// from noise
+		long smallest = columnBits(full.B, 0);
+		for (size_t j = 1; j < n; j++)
+			smallest = std::min(smallest, columnBits(full.B, j));
+		if ((long)n * smallest + MARGIN > (long)precision || (long)full.A.bits() + 2 * MARGIN > (long)precision)
+			break;
+	}
+
+	// any relation has norm at least 1 / max |H_jj|
+	mpfr_set_zero(full.t0.ptr(), 1);
+	for (size_t j = 0; j + 1 < n; j++)
+		if (mpfr_cmpabs(full.h(j, j), full.t0.ptr()) > 0)
+			mpfr_abs(full.t0.ptr(), full.h(j, j), MPFR_RNDN);
+	mpfr_ui_div(bound.ptr(), 1, full.t0.ptr(), MPFR_RNDN);
+
+	if (relationIndex == n)
+		return val::array();
+	found = true;
+	std::vector<mpz_srcptr> a(n);
+	for (size_t i = 0; i < n; i++)
+		a[i] = full.B(i, relationIndex);
+	return relation(a, v);
+}
+
+val IntegerRelation::lll(val x)
+{
+	Trace::Span span("IntegerRelation.lll", precision);
+	iterations = 0;
+	found = false;
+	mpfr_set_zero(bound.ptr(), 1);
+	mpfr_set_nan(residual.ptr());
+	FloatArray xs = inputs(x, precision);
+	if (!finite(xs))
+		return val::array();
+	size_t n = xs.size();
+	std::vector<mpfr_srcptr> v(n);
+	Float scaled(precision), largest(precision, 0);
+	for (size_t i = 0; i < n; i++)
+	{
+		v[i] = xs.at(i);
+		if (mpfr_cmpabs(v[i], largest.ptr()) > 0)
+			mpfr_abs(largest.ptr(), v[i], MPFR_RNDN);
+	}
+	if (mpfr_zero_p(largest.ptr()))
+		mpfr_set_ui(largest.ptr(), 1, MPFR_RNDN);
+
+	// rows b_1 ... b_n = (e_i, x_i 2^(precision - e)), 1-based as in Cohen,
+	// d_i = |b*_1|^2 ... |b*_i|^2 and lambda_ij = d_j mu_ij are integers
+	Integers b(n + 1, n + 1), lambda(n + 1, n + 1), d(1, n + 1);
+	for (size_t i = 1; i <= n; i++)
+	{
+		mpz_set_ui(b(i, i - 1), 1);
+		mpfr_mul_2si(scaled.ptr(), v[i - 1], (long)precision - mpfr_get_exp(largest.ptr()), MPFR_RNDN);
+		mpfr_get_z(b(i, n), scaled.ptr(), MPFR_RNDN);
+	}
+	mpz_t u, q;
+	mpz_inits(u, q, nullptr);
+	auto inner = [&](mpz_ptr out, size_t i, size_t j) {
+		mpz_set_ui(out, 0);
+		for (size_t c = 0; c <= n; c++)
+			mpz_addmul(out, b(i, c), b(j, c));
+	};
+	// size reduction of b_k by b_l
+	auto reduceRow = [&](size_t k, size_t l) {
+		mpz_mul_2exp(u, lambda(k, l), 1);
+		if (mpz_cmpabs(u, d(0, l)) <= 0)
+			return;
+		// q = floor((2 lambda_kl + d_l) / (2 d_l))
+		mpz_add(u, u, d(0, l));
+		mpz_mul_2exp(q, d(0, l), 1);
+		mpz_fdiv_q(q, u, q);
+		for (size_t c = 0; c <= n; c++)
+			mpz_submul(b(k, c), q, b(l, c));
+		mpz_submul(lambda(k, l), q, d(0, l));
+		for (size_t i = 1; i < l; i++)
+			mpz_submul(lambda(k, i), q, lambda(l, i));
+	};
+	size_t k = 2, kmax = 1;
+	auto swapRows = [&]() {
+		for (size_t c = 0; c <= n; c++)
+			mpz_swap(b(k, c), b(k - 1, c));
+		for (size_t j = 1; j + 1 < k; j++)
+			mpz_swap(lambda(k, j), lambda(k - 1, j));
+		// B = (d_k-2 d_k + lambda^2) / d_k-1 is the new d_k-1
+		mpz_srcptr l = lambda(k, k - 1);
+		mpz_mul(q, d(0, k - 2), d(0, k));
+		mpz_addmul(q, l, l);
+		mpz_divexact(q, q, d(0, k - 1));
+		for (size_t i = k + 1; i <= kmax; i++)
+		{
+			mpz_set(u, lambda(i, k));
+			mpz_mul(lambda(i, k), d(0, k), lambda(i, k - 1));
+			mpz_submul(lambda(i, k), l, u);
+			mpz_divexact(lambda(i, k), lambda(i, k), d(0, k - 1));
+			mpz_mul(lambda(i, k - 1), q, u);
+			mpz_addmul(lambda(i, k - 1), l, lambda(i, k));
+			mpz_divexact(lambda(i, k - 1), lambda(i, k - 1), d(0, k));
+		}
+		mpz_set(d(0, k - 1), q);
+	};
+
+	mpz_set_ui(d(0, 0), 1);
+	inner(d(0, 1), 1, 1);
+	mpz_t left, right;
+	mpz_inits(left, right, nullptr);
+	while (k <= n && iterations < maxIterations)
+	{
+		// incremental Gram-Schmidt
+		if (k > kmax)
+		{
+			kmax = k;
+			for (size_t j = 1; j <= k; j++)
+			{
+				inner(u, k, j);
+				for (size_t i = 1; i < j; i++)
+				{
+					mpz_mul(u, u, d(0, i));
+					mpz_submul(u, lambda(k, i), lambda(j, i));
+					mpz_divexact(u, u, d(0, i - 1));
+				}
+				mpz_set(j < k ? lambda(k, j) : d(0, k), u);
+			}
+		}
+		// Lovasz condition with 3/4: 4 d_k d_k-2 >= 3 d_k-1^2 - 4 lambda^2
+		reduceRow(k, k - 1);
+		mpz_mul(left, d(0, k), d(0, k - 2));
+		mpz_mul_2exp(left, left, 2);
+		mpz_mul(right, d(0, k - 1), d(0, k - 1));
+		mpz_mul_ui(right, right, 3);
+		mpz_mul(u, lambda(k, k - 1), lambda(k, k - 1));
+		mpz_submul_ui(right, u, 4);
+		if (mpz_cmp(left, right) < 0)
+		{
+			swapRows();
+			k = std::max<size_t>(2, k - 1);
+			iterations++;
+			continue;
+		}
+		for (size_t l = k - 1; l-- > 1;)
+			reduceRow(k, l);
+		k++;
+	}
+
+	// any lattice vector outside the line of b_1 has norm at least
+	// min |b*_i| for i >= 2, a relation a gives the vector (a, ~ 2^p a.x)
+	Float t(53);
+	mpfr_set_inf(bound.ptr(), 1);
+	for (size_t i = 2; i <= kmax; i++)
+	{
+		mpfr_set_z(t.ptr(), d(0, i), MPFR_RNDN);
+		mpfr_div_z(t.ptr(), t.ptr(), d(0, i - 1), MPFR_RNDN);
+		mpfr_sqrt(t.ptr(), t.ptr(), MPFR_RNDN);
+		mpfr_min(bound.ptr(), bound.ptr(), t.ptr(), MPFR_RNDN);
+	}
+	mpz_clears(u, q, left, right, nullptr);
+
+	std::vector<mpz_srcptr> a(n);
+	for (size_t i = 0; i < n; i++)
+		a[i] = b(1, i);
+	val out = relation(a, v);
+	long bits = 0;
+	mpz_t norm;
+	mpz_init(norm);
+	for (size_t i = 0; i < n; i++)
+	{
+		bits = std::max<long>(bits, mpz_sizeinbase(a[i], 2));
+		mpz_addmul(norm, a[i], a[i]);
+	}
+	// |a| <= 2^(e/2) for |a|^2 < 2^e
+	long gap = mpfr_inf_p(bound.ptr()) ? GAP : mpfr_get_exp(bound.ptr()) - 1 - ((long)mpz_sizeinbase(norm, 2) + 1) / 2;
+	mpz_clear(norm);
+	found = vanishes(residual.ptr(), mpfr_get_exp(largest.ptr()), bits, n, precision) && gap >= GAP;
+	return found ? out : val::array();
+}
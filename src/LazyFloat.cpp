@@ -0,0 +1,398 @@
+#include <mpfr.h>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+#include "LazyFloat.hpp"
+
+static int assign(Float &out, const Float &op)
+{
+	return mpfr_set(out.ptr(), op.ptr(), (mpfr_rnd_t)out.getRounding());
+}
+
+LazyFloat::LazyFloat(val v)
+{
+	if (v.isNumber())
+	{
+		Float nan(v.as<prec_t>());
+		node = leaf(nan);
+		precision = nan.getPrecision();
+		rounding = MPFR_RNDN;
+	}
+	else if (v.instanceof(val::module_property("LazyFloat")))
+		*this = v.as<const LazyFloat &>();
+	else
+		*this = LazyFloat(v.as<const Float &>());
+}
+
+LazyFloat::LazyFloat(const Float &op)
+	: node(leaf(op)), precision(op.getPrecision()), rounding(op.getRounding()) {}
+
+// rounding and precision apply to the operations recorded afterwards
+int LazyFloat::getRounding() const { return rounding; }
+LazyFloat::builder_pattern LazyFloat::setRounding(int mode) { rounding = mode; }
+LazyFloat::prec_t LazyFloat::getPrecision() const { return precision; }
+LazyFloat::builder_pattern LazyFloat::setPrecision(prec_t prec) { precision = prec; }
+bool LazyFloat::isPending() const { return !node->value; }
+
+LazyFloat::builder_pattern LazyFloat::set(val v)
+{
+	if (v.isNumber() || v.isString())
+	{
+		Float op(precision);
+		op.setRounding(rounding);
+		op.set(v);
+		node = leaf(op);
+	}
+	else
+	{
+		std::shared_ptr<Node> op = operand(v);
+		if (op->precision == precision)
+			node = op;
+		else
+		{
+			node = binary(Unary, op, nullptr);
+			node->unary = assign;
+		}
+	}
+}
+
+LazyFloat::builder_pattern LazyFloat::add(val v) { node = binary(Add, node, operand(v)); }
+LazyFloat::builder_pattern LazyFloat::sub(val v) { node = binary(Sub, node, operand(v)); }
+LazyFloat::builder_pattern LazyFloat::mul(val v) { node = binary(Mul, node, operand(v)); }
+LazyFloat::builder_pattern LazyFloat::div(val v) { node = binary(Div, node, operand(v)); }
+
+// same operand order as Float: this * a + b, this * a + b * c
+LazyFloat::builder_pattern LazyFloat::fma(val a, val b) { node = binary(Add, binary(Mul, node, operand(a)), operand(b)); }
+LazyFloat::builder_pattern LazyFloat::fms(val a, val b) { node = binary(Sub, binary(Mul, node, operand(a)), operand(b)); }
+LazyFloat::builder_pattern LazyFloat::fmma(val a, val b, val c) { node = binary(Add, binary(Mul, node, operand(a)), binary(Mul, operand(b), operand(c))); }
+LazyFloat::builder_pattern LazyFloat::fmms(val a, val b, val c) { node = binary(Sub, binary(Mul, node, operand(a)), binary(Mul, operand(b), operand(c))); }
+
+LazyFloat::builder_pattern LazyFloat::sqr() { node = binary(Mul, node, node); }
+LazyFloat::builder_pattern LazyFloat::sqrt() { unary(&Float::op_sqrt); }
+LazyFloat::builder_pattern LazyFloat::rec_sqrt() { unary(&Float::op_rec_sqrt); }
+LazyFloat::builder_pattern LazyFloat::cbrt() { unary(&Float::op_cbrt); }
+LazyFloat::builder_pattern LazyFloat::neg() { unary(&Float::op_neg); }
+LazyFloat::builder_pattern LazyFloat::abs() { unary(&Float::op_abs); }
+LazyFloat::builder_pattern LazyFloat::log() { unary(&Float::op_log); }
+LazyFloat::builder_pattern LazyFloat::log2() { unary(&Float::op_log2); }
+LazyFloat::builder_pattern LazyFloat::log10() { unary(&Float::op_log10); }
+LazyFloat::builder_pattern LazyFloat::log1p() { unary(&Float::op_log1p); }
+LazyFloat::builder_pattern LazyFloat::exp() { unary(&Float::op_exp); }
+LazyFloat::builder_pattern LazyFloat::exp2() { unary(&Float::op_exp2); }
+LazyFloat::builder_pattern LazyFloat::exp10() { unary(&Float::op_exp10); }
+LazyFloat::builder_pattern LazyFloat::expm1() { unary(&Float::op_expm1); }
+LazyFloat::builder_pattern LazyFloat::cos() { unary(&Float::op_cos); }
+LazyFloat::builder_pattern LazyFloat::sin() { unary(&Float::op_sin); }
+LazyFloat::builder_pattern LazyFloat::tan() { unary(&Float::op_tan); }
+LazyFloat::builder_pattern LazyFloat::sec() { unary(&Float::op_sec); }
+LazyFloat::builder_pattern LazyFloat::csc() { unary(&Float::op_csc); }
+LazyFloat::builder_pattern LazyFloat::cot() { unary(&Float::op_cot); }
+LazyFloat::builder_pattern LazyFloat::acos() { unary(&Float::op_acos); }
+LazyFloat::builder_pattern LazyFloat::asin() { unary(&Float::op_asin); }
+LazyFloat::builder_pattern LazyFloat::atan() { unary(&Float::op_atan); }
+LazyFloat::builder_pattern LazyFloat::cosh() { unary(&Float::op_cosh); }
+LazyFloat::builder_pattern LazyFloat::sinh() { unary(&Float::op_sinh); }
+LazyFloat::builder_pattern LazyFloat::tanh() { unary(&Float::op_tanh); }
+LazyFloat::builder_pattern LazyFloat::sech() { unary(&Float::op_sech); }
+LazyFloat::builder_pattern LazyFloat::csch() { unary(&Float::op_csch); }
+LazyFloat::builder_pattern LazyFloat::coth() { unary(&Float::op_coth); }
+LazyFloat::builder_pattern LazyFloat::acosh() { unary(&Float::op_acosh); }
+LazyFloat::builder_pattern LazyFloat::asinh() { unary(&Float::op_asinh); }
+LazyFloat::builder_pattern LazyFloat::atanh() { unary(&Float::op_atanh); }
+LazyFloat::builder_pattern LazyFloat::eint() { unary(&Float::op_eint); }
+LazyFloat::builder_pattern LazyFloat::li2() { unary(&Float::op_li2); }
+LazyFloat::builder_pattern LazyFloat::gamma() { unary(&Float::op_gamma); }
+LazyFloat::builder_pattern LazyFloat::lngamma() { unary(&Float::op_lngamma); }
+LazyFloat::builder_pattern LazyFloat::digamma() { unary(&Float::op_digamma); }
+LazyFloat::builder_pattern LazyFloat::zeta() { unary(&Float::op_zeta); }
+LazyFloat::builder_pattern LazyFloat::erf() { unary(&Float::op_erf); }
+LazyFloat::builder_pattern LazyFloat::erfc() { unary(&Float::op_erfc); }
+LazyFloat::builder_pattern LazyFloat::j0() { unary(&Float::op_j0); }
+LazyFloat::builder_pattern LazyFloat::j1() { unary(&Float::op_j1); }
+LazyFloat::builder_pattern LazyFloat::y0() { unary(&Float::op_y0); }
+LazyFloat::builder_pattern LazyFloat::y1() { unary(&Float::op_y1); }
+LazyFloat::builder_pattern LazyFloat::ai() { unary(&Float::op_ai); }
+
+// OBSERVATION
+
+const Float &LazyFloat::value() { return evaluate(node); }
+
+Float LazyFloat::toFloat()
+{
+	Float out(value());
+	out.setRounding(rounding);
+	return out;
+}
+
+std::string LazyFloat::toString(int base, int n) { return toFloat().toString(base, n); }
+std::string LazyFloat::toString(int base) { return toString(base, 0); }
+std::string LazyFloat::toString() { return toString(10, 0); }
+double LazyFloat::toNumber() { return mpfr_get_d(value().ptr(), (mpfr_rnd_t)rounding); }
+
+int LazyFloat::compare(LazyFloat &self, val v)
+{
+	if (v.isNumber())
+		return mpfr_cmp_d(self.value().ptr(), v.as<double>());
+	else if (v.instanceof(val::module_property("LazyFloat")))
+		return mpfr_cmp(self.value().ptr(), v.as<LazyFloat &>().value().ptr());
+	else
+		return mpfr_cmp(self.value().ptr(), v.as<const Float &>().ptr());
+}
+
+bool LazyFloat::less(val v) { return compare(*this, v) < 0; }
+bool LazyFloat::greater(val v) { return compare(*this, v) > 0; }
+bool LazyFloat::less_equal(val v) { return !greater(v); }
+bool LazyFloat::greater_equal(val v) { return !less(v); }
+bool LazyFloat::equal(val v) { return compare(*this, v) == 0; }
+bool LazyFloat::not_equal(val v) { return !equal(v); }
+
+// RECORDING
+
+std::shared_ptr<LazyFloat::Node> LazyFloat::leaf(const Float &op)
+{
+	std::shared_ptr<Node> n = std::make_shared<Node>();
+	n->value.reset(new Float(op));
+	n->value->setRounding(op.getRounding());
+	n->precision = op.getPrecision();
+	n->rounding = op.getRounding();
+	return n;
+}
+
+// numbers are captured exactly, Floats are captured by value
+std::shared_ptr<LazyFloat::Node> LazyFloat::operand(val v) const
+{
+	if (v.isNumber())
+		return leaf(Float(53, v.as<double>()));
+	else if (v.instanceof(val::module_property("LazyFloat")))
+		return v.as<const LazyFloat &>().node;
+	else
+		return leaf(v.as<const Float &>());
+}
+
+std::shared_ptr<LazyFloat::Node> LazyFloat::binary(Kind kind, std::shared_ptr<Node> a, std::shared_ptr<Node> b) const
+{
+	std::shared_ptr<Node> n = std::make_shared<Node>();
+	n->kind = kind;
+	n->a = std::move(a);
+	n->b = std::move(b);
+	n->precision = precision;
+	n->rounding = rounding;
+	return n;
+}
+
+void LazyFloat::unary(unary_t fn)
+{
+	std::shared_ptr<Node> n = binary(Unary, node, nullptr);
+	n->unary = fn;
+	if (fn == &Float::op_sin || fn == &Float::op_cos || fn == &Float::op_sinh || fn == &Float::op_cosh)
+	{
+		std::vector<std::weak_ptr<Node>> &users = node->users;
+		for (size_t i = 0; i < users.size();)
+			if (users[i].expired())
+			{
+				users[i] = users.back();
+				users.pop_back();
+			}
+			else
+				i++;
+		users.push_back(n);
+	}
+	node = n;
+}
+
+// unlinks long unevaluated chains iteratively instead of through nested destructors
+LazyFloat::Node::~Node()
+{
+	std::vector<std::shared_ptr<Node>> orphans;
+	orphans.push_back(std::move(a));
+	orphans.push_back(std::move(b));
+	while (!orphans.empty())
+	{
+		std::shared_ptr<Node> n = std::move(orphans.back());
+		orphans.pop_back();
+		if (n && n.use_count() == 1)
+		{
+			orphans.push_back(std::move(n->a));
+			orphans.push_back(std::move(n->b));
+		}
+	}
+}
+
+// EVALUATION
+
+// iterative post-order walk, long builder chains must not exhaust the stack
+const Float &LazyFloat::evaluate(const std::shared_ptr<Node> &root)
+{
+	std::vector<Node *> stack{root.get()};
+	while (!stack.empty())
+	{
+		Node *n = stack.back();
+		if (n->value)
+		{
+			stack.pop_back();
+			continue;
+		}
+		Plan p = plan(n);
+		bool ready = true;
+		for (int i = 0; i < p.count; i++)
+			if (!p.inputs[i]->value)
+			{
+				stack.push_back(p.inputs[i]);
+				ready = false;
+			}
+		if (ready)
+		{
+			compute(n);
+			stack.pop_back();
+		}
+	}
+	return *root->value;
+}
+
+// a product can be folded into its consumer when nothing else refers to it
+LazyFloat::Plan LazyFloat::plan(Node *n)
+{
+	auto fusable = [](const std::shared_ptr<Node> &m) {
+		return m && m->kind == Mul && !m->value && m.use_count() == 1;
+	};
+	Plan p;
+	switch (n->kind)
+	{
+	case Add:
+	case Sub:
+		if (fusable(n->a) && fusable(n->b))
+		{
+			p.kind = n->kind == Add ? Plan::Fmma : Plan::Fmms;
+			p.inputs[p.count++] = n->a->a.get();
+			p.inputs[p.count++] = n->a->b.get();
+			p.inputs[p.count++] = n->b->a.get();
+			p.inputs[p.count++] = n->b->b.get();
+			return p;
+		}
+		if (fusable(n->a))
+		{
+			p.kind = n->kind == Add ? Plan::Fma : Plan::Fms;
+			p.inputs[p.count++] = n->a->a.get();
+			p.inputs[p.count++] = n->a->b.get();
+			p.inputs[p.count++] = n->b.get();
+			return p;
+		}
+		if (n->kind == Add && fusable(n->b))
+		{
+			p.kind = Plan::Fma;
+			p.inputs[p.count++] = n->b->a.get();
+			p.inputs[p.count++] = n->b->b.get();
+			p.inputs[p.count++] = n->a.get();
+			return p;
+		}
+		break;
+	case Mul:
+		if (n->a == n->b)
+		{
+			p.kind = Plan::Sqr;
+			p.inputs[p.count++] = n->a.get();
+			return p;
+		}
+		break;
+	default:
+		break;
+	}
+	if (n->a)
+		p.inputs[p.count++] = n->a.get();
+	if (n->b)
+		p.inputs[p.count++] = n->b.get();
+	return p;
+}
+
+void LazyFloat::compute(Node *n)
+{
+	Plan p = plan(n);
+	n->value.reset(new Float(n->precision));
+	n->value->setRounding(n->rounding);
+	mpfr_ptr out = n->value->ptr();
+	mpfr_rnd_t rnd = (mpfr_rnd_t)n->rounding;
+	auto in = [&p](int i) { return p.inputs[i]->value->ptr(); };
+
+	switch (p.kind)
+	{
+	case Plan::Sqr:
+		mpfr_sqr(out, in(0), rnd);
+		break;
+	case Plan::Fma:
+		mpfr_fma(out, in(0), in(1), in(2), rnd);
+		break;
+	case Plan::Fms:
+		mpfr_fms(out, in(0), in(1), in(2), rnd);
+		break;
+	case Plan::Fmma:
+		mpfr_fmma(out, in(0), in(1), in(2), in(3), rnd);
+		break;
+	case Plan::Fmms:
+		mpfr_fmms(out, in(0), in(1), in(2), in(3), rnd);
+		break;
+	case Plan::Direct:
+		switch (n->kind)
+		{
+		case Add:
+			mpfr_add(out, in(0), in(1), rnd);
+			break;
+		case Sub:
+			mpfr_sub(out, in(0), in(1), rnd);
+			break;
+		case Mul:
+			mpfr_mul(out, in(0), in(1), rnd);
+			break;
+		case Div:
+			mpfr_div(out, in(0), in(1), rnd);
+			break;
+		case Unary:
+		{
+			const Float &op = *n->a->value;
+			Node *s = nullptr;
+			if (n->unary == &Float::op_sin && (s = sibling(n, &Float::op_cos)))
+				Float::op_sin_cos(*n->value, *s->value, op);
+			else if (n->unary == &Float::op_cos && (s = sibling(n, &Float::op_sin)))
+				Float::op_sin_cos(*s->value, *n->value, op);
+			else if (n->unary == &Float::op_sinh && (s = sibling(n, &Float::op_cosh)))
+				Float::op_sinh_cosh(*n->value, *s->value, op);
+			else if (n->unary == &Float::op_cosh && (s = sibling(n, &Float::op_sinh)))
+				Float::op_sinh_cosh(*s->value, *n->value, op);
+			else
+				n->unary(*n->value, op);
+			if (s)
+				settle(s);
+			break;
+		}
+		case Leaf:
+			break;
+		}
+		break;
+	}
+	settle(n);
+}
+
+// pending node applying `pair` to the same input with the same rounding, allocated for a joint computation
+LazyFloat::Node *LazyFloat::sibling(Node *n, unary_t pair)
+{
+	for (const std::weak_ptr<Node> &user : n->a->users)
+	{
+		std::shared_ptr<Node> s = user.lock();
+		if (s && s.get() != n && s->kind == Unary && s->unary == pair && !s->value && s->rounding == n->rounding)
+		{
+			s->value.reset(new Float(s->precision));
+			s->value->setRounding(s->rounding);
+			return s.get();
+		}
+	}
+	return nullptr;
+}
+
+// an evaluated node becomes a leaf and releases its operands
+void LazyFloat::settle(Node *n)
+{
+	n->kind = Leaf;
+	n->unary = nullptr;
+	n->a.reset();
+	n->b.reset();
+}
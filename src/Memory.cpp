@@ -0,0 +1,124 @@
+#include <mpfr.h>
+#include <gmp.h>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+#include "Memory.hpp"
+#include "Quadrature.hpp"
+
+static size_t used = 0, peak = 0, budget = 0;
+static double trimRatio = 0.9;
+static bool trimPending = false;
+
+// installed before main, GMP has allocated nothing yet
+struct MemoryHooks
+{
+	MemoryHooks() { mp_set_memory_functions(Memory::allocate, Memory::reallocate, Memory::release); }
+};
+static MemoryHooks hooks;
+
+size_t Memory::getUsed() { return used; }
+size_t Memory::getPeak() { return peak; }
+size_t Memory::getBudget() { return budget; }
+void Memory::setBudget(size_t bytes) { budget = bytes; }
+double Memory::getTrimRatio() { return trimRatio; }
+void Memory::setTrimRatio(double ratio) { trimRatio = ratio; }
+void Memory::resetPeak() { peak = used; }
+
+void Memory::trim()
+{
+	mpfr_free_cache();
+	Quadrature::clearCache();
+	trimPending = false;
+}
+
+// why count Floats of precision prec cannot be allocated, or nullptr;
+// trims first when they would not fit
+const char *Memory::refuse(prec_t prec, size_t count)
+{
+	if (prec < MPFR_PREC_MIN || prec > MPFR_PREC_MAX)
+		return "precision out of range";
+	size_t size = mpfr_custom_get_size(prec) + sizeof(mp_limb_t);
+	auto fits = [&]() { return used < budget && count <= (budget - used) / size; };
+	if (trimPending || (budget && !fits()))
+		trim();
+	if (budget && !fits())
+		return "precision exceeds the memory budget";
+	return nullptr;
+}
+
+bool Memory::admit(prec_t prec, size_t count)
+{
+	const char *reason = refuse(prec, count);
+	if (reason)
+		std::cerr << "error: " << reason << std::endl;
+	return !reason;
+}
+
+// a JS exception skips the C++ destructors, so it is only thrown from the
+// bindings, before any native state exists
+void Memory::check(prec_t prec, size_t count)
+{
+	const char *reason = refuse(prec, count);
+	if (reason)
+	{
+		val::global("RangeError").new_(std::string(reason)).throw_();
+		std::abort();
+	}
+}
+
+// the hooks never throw, the budget is checked at the next admit(); past
+// trimRatio of it the caches are dropped there
+void Memory::account(size_t size)
+{
+	used += size;
+	peak = used > peak ? used : peak;
+	if (budget && used > budget * trimRatio)
+		trimPending = true;
+}
+
+// a real allocation failure cannot be recovered from inside GMP
+static void *checked(void *ptr)
+{
+	if (!ptr)
+	{
+		std::cerr << "error: out of memory" << std::endl;
+		std::abort();
+	}
+	return ptr;
+}
+
+void *Memory::allocate(size_t size)
+{
+	void *ptr = std::malloc(size);
+	if (!ptr)
+	{
+		mpfr_free_pool();
+		ptr = checked(std::malloc(size));
+	}
+	account(size);
+	return ptr;
+}
+
+void *Memory::reallocate(void *ptr, size_t old, size_t size)
+{
+	void *out = std::realloc(ptr, size);
+	if (!out)
+	{
+		mpfr_free_pool();
+		out = checked(std::realloc(ptr, size));
+	}
+	used -= old > used ? used : old;
+	account(size);
+	return out;
+}
+
+void Memory::release(void *ptr, size_t size)
+{
+	std::free(ptr);
+	used = size > used ? 0 : used - size;
+}
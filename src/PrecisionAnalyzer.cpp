@@ -0,0 +1,117 @@
+#include <mpfr.h>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <vector>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+#include "PrecisionAnalyzer.hpp"
+#include "Trace.hpp"
+
+PrecisionAnalyzer::PrecisionAnalyzer(const Formula &formula) : formula(formula) {}
+
+PrecisionAnalyzer::prec_t PrecisionAnalyzer::getGuard() const { return guard; }
+PrecisionAnalyzer::builder_pattern PrecisionAnalyzer::setGuard(prec_t guard) { this->guard = guard; }
+PrecisionAnalyzer::prec_t PrecisionAnalyzer::getReference() const { return reference; }
+PrecisionAnalyzer::prec_t PrecisionAnalyzer::getUniform() const { return uniform; }
+const std::vector<PrecisionAnalyzer::prec_t> &PrecisionAnalyzer::getMinimal() const { return minimal; }
+const std::vector<PrecisionAnalyzer::prec_t> &PrecisionAnalyzer::getJoint() const { return joint; }
+
+bool PrecisionAnalyzer::accurate(mpfr_srcptr const *args, const std::vector<prec_t> &precisions, mpfr_srcptr expected, prec_t bits)
+{
+	Float result(reference), difference(reference);
+	formula.evaluate(args, result.ptr(), MPFR_RNDN, precisions.data());
+	if (!mpfr_regular_p(expected))
+		return mpfr_nan_p(expected) ? mpfr_nan_p(result.ptr()) : mpfr_equal_p(result.ptr(), expected);
+	mpfr_sub(difference.ptr(), result.ptr(), expected, MPFR_RNDN);
+	if (mpfr_zero_p(difference.ptr()))
+		return true;
+	return mpfr_number_p(difference.ptr()) && mpfr_get_exp(expected) - mpfr_get_exp(difference.ptr()) >= (Float::exp_t)bits;
+}
+
+bool PrecisionAnalyzer::analyze(mpfr_srcptr const *args, prec_t bits)
+{
+	Trace::Span span("PrecisionAnalyzer.analyze", bits);
+	size_t n = formula.getTape().size();
+	reference = bits + guard;
+	minimal.assign(n, reference);
+	joint.assign(n, reference);
+	uniform = reference;
+	if (!n)
+		return false;
+
+	Float expected(reference);
+	formula.evaluate(args, expected.ptr(), MPFR_RNDN);
+	if (mpfr_nan_p(expected.ptr()))
+		return false;
+
+	// smallest precision in [MPFR_PREC_MIN, reference] for which set(p)
+	// keeps the result accurate, assuming more bits never hurt
+	std::vector<prec_t> precisions(n, reference);
+	auto bisect = [&](const std::function<void(prec_t)> &set) {
+		prec_t lo = MPFR_PREC_MIN, hi = reference;
+		while (lo < hi)
+		{
+			prec_t mid = lo + (hi - lo) / 2;
+			set(mid);
+			if (accurate(args, precisions, expected.ptr(), bits))
+				hi = mid;
+			else
+				lo = mid + 1;
+		}
+		return hi;
+	};
+
+	for (size_t i = 0; i < n; i++)
+	{
+		minimal[i] = bisect([&](prec_t p) { precisions[i] = p; });
+		precisions[i] = reference;
+	}
+
+	for (prec_t extra = 0;; extra = extra ? 2 * extra : 1)
+	{
+		for (size_t i = 0; i < n; i++)
+			joint[i] = std::min(minimal[i] + extra, reference);
+		if (accurate(args, joint, expected.ptr(), bits) || extra >= reference)
+			break;
+	}
+
+	uniform = bisect([&](prec_t p) { std::fill(precisions.begin(), precisions.end(), p); });
+	return true;
+}
+
+val PrecisionAnalyzer::analyze(val args, int digits)
+{
+	std::vector<Float> numbers;
+	std::vector<mpfr_srcptr> ptrs = Formula::arguments(args, numbers);
+	if (ptrs.size() != (size_t)formula.getVariableCount())
+	{
+		std::cerr << "error: formula expects " << formula.getVariableCount() << " arguments, got " << ptrs.size() << std::endl;
+		return val::null();
+	}
+	prec_t bits = std::ceil(digits * std::log2(10.0));
+	if (!analyze(ptrs.data(), bits))
+	{
+		std::cerr << "error: formula has no value at this point" << std::endl;
+		return val::null();
+	}
+	val operations = val::array();
+	for (size_t i = 0; i < minimal.size(); i++)
+	{
+		val op = val::object();
+		op.set("index", (int)i);
+		op.set("op", formula.describe(i));
+		op.set("minimal", minimal[i]);
+		op.set("joint", joint[i]);
+		operations.call<void>("push", op);
+	}
+	val out = val::object();
+	out.set("bits", bits);
+	out.set("reference", reference);
+	out.set("uniform", uniform);
+	out.set("operations", operations);
+	return out;
+}
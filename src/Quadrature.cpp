@@ -0,0 +1,345 @@
+#include <mpfr.h>
+#include <cmath>
+#include <iostream>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+#include "Quadrature.hpp"
+#include "Formula.hpp"
+#include "Constants.hpp"
+#include "Trace.hpp"
+
+std::map<std::tuple<int, int, Quadrature::prec_t>, std::shared_ptr<const Quadrature::Nodes>> Quadrature::cache;
+
+// bits above the target precision for the nodes and the sums
+static const Quadrature::prec_t GUARD = 32;
+
+Quadrature::Nodes::Nodes(size_t length, prec_t precision)
+	: x(length, precision), c(length, precision), w(length, precision), center(precision)
+{
+	mpfr_set_zero(center.ptr(), 1);
+}
+
+Quadrature::Quadrature(int rule, prec_t precision)
+	: rule((Rule)rule), precision(precision), maxLevel(rule == GaussLegendre ? 7 : 10), error(53) {}
+
+Quadrature::prec_t Quadrature::getPrecision() const { return precision; }
+Quadrature::builder_pattern Quadrature::setPrecision(prec_t precision) { this->precision = precision; }
+int Quadrature::getMaxLevel() const { return maxLevel; }
+Quadrature::builder_pattern Quadrature::setMaxLevel(int level) { maxLevel = level; }
+
+// levels used and error estimate (difference of the last two levels) of the last integration
+int Quadrature::getLevels() const { return levels; }
+Float Quadrature::getError() const { return error; }
+
+size_t Quadrature::cacheSize() { return cache.size(); }
+void Quadrature::clearCache() { cache.clear(); }
+
+std::shared_ptr<const Quadrature::Nodes> Quadrature::nodes(Rule rule, int level, prec_t precision)
+{
+	auto key = std::make_tuple((int)rule, level, precision);
+	auto found = cache.find(key);
+	if (found != cache.end())
+		return found->second;
+	std::shared_ptr<const Nodes> computed = rule == GaussLegendre ? gaussLegendre(3 << level, precision) : tanhSinh(level, precision);
+	cache[key] = computed;
+	return computed;
+}
+
+// P_n(x) and P'_n(x) by the three-term recurrence, at the precision of x
+static void legendre(int n, mpfr_srcptr x, mpfr_ptr p, mpfr_ptr dp)
+{
+	mpfr_prec_t prec = mpfr_get_prec(x);
+	mpfr_t previous, t;
+	mpfr_init2(previous, prec);
+	mpfr_init2(t, prec);
+	mpfr_set_ui(previous, 1, MPFR_RNDN);
+	mpfr_set(p, x, MPFR_RNDN);
+	for (int k = 1; k < n; k++)
+	{
+		// (k + 1) P_k+1 = (2k + 1) x P_k - k P_k-1
+		mpfr_mul(t, x, p, MPFR_RNDN);
+		mpfr_mul_ui(t, t, 2 * k + 1, MPFR_RNDN);
+		mpfr_mul_ui(previous, previous, k, MPFR_RNDN);
+		mpfr_sub(t, t, previous, MPFR_RNDN);
+		mpfr_div_ui(t, t, k + 1, MPFR_RNDN);
+		mpfr_swap(previous, p);
+		mpfr_swap(p, t);
+	}
+	// P'_n = n (x P_n - P_n-1) / (x^2 - 1)
+	mpfr_mul(dp, x, p, MPFR_RNDN);
+	mpfr_sub(dp, dp, previous, MPFR_RNDN);
+	mpfr_mul_ui(dp, dp, n, MPFR_RNDN);
+	mpfr_sqr(t, x, MPFR_RNDN);
+	mpfr_sub_ui(t, t, 1, MPFR_RNDN);
+	mpfr_div(dp, dp, t, MPFR_RNDN);
+	mpfr_clear(previous);
+	mpfr_clear(t);
+}
+
+// roots of P_n by Newton: in double from the usual cosine estimates, then
+// doubling the precision at each step up to the working precision, where it
+// runs until the correction is negligible.
+// Weights 2 / ((1 - x^2) P'_n(x)^2)
+std::shared_ptr<Quadrature::Nodes> Quadrature::gaussLegendre(int n, prec_t precision)
+{
+	auto out = std::make_shared<Nodes>(n / 2, precision);
+	prec_t work = precision + 16;
+	mpfr_t x, p, dp, t;
+	mpfr_inits2(work, x, p, dp, t, (mpfr_ptr) nullptr);
+	for (int i = 0; i < n / 2; i++)
+	{
+		double z = std::cos(M_PI * (i + 0.75) / (n + 0.5)), dz = 1;
+		for (int steps = 0; steps < 100 && std::fabs(dz) > 1e-15; steps++)
+		{
+			double p0 = 1, p1 = z;
+			for (int k = 1; k < n; k++)
+			{
+				double p2 = ((2 * k + 1) * z * p1 - k * p0) / (k + 1);
+				p0 = p1;
+				p1 = p2;
+			}
+			dz = p1 / (n * (z * p1 - p0) / (z * z - 1));
+			z -= dz;
+		}
+
+		prec_t current = 53;
+		mpfr_set_prec(x, current);
+		mpfr_set_d(x, z, MPFR_RNDN);
+		// doubling the precision until work, then Newton steps at work until
+		// the update is below 2^-work: once it is below 2^-work/2, the next
+		// step is the last one
+		bool last = false;
+		for (int steps = 0; steps < 1000; steps++)
+		{
+			current = std::min(2 * current, work);
+			mpfr_prec_round(x, current, MPFR_RNDN);
+			mpfr_set_prec(p, current);
+			mpfr_set_prec(dp, current);
+			legendre(n, x, p, dp);
+			mpfr_div(p, p, dp, MPFR_RNDN);
+			mpfr_sub(x, x, p, MPFR_RNDN);
+			if (current < work)
+				continue;
+			if (last || mpfr_zero_p(p) || mpfr_get_exp(p) <= mpfr_get_exp(x) - (mpfr_exp_t)work)
+				break;
+			last = mpfr_get_exp(p) < mpfr_get_exp(x) - (mpfr_exp_t)work / 2;
+		}
+		legendre(n, x, p, dp);
+		mpfr_set(out->x.at(i), x, MPFR_RNDN);
+		mpfr_ui_sub(out->c.at(i), 1, x, MPFR_RNDN);
+		mpfr_sqr(t, x, MPFR_RNDN);
+		mpfr_ui_sub(t, 1, t, MPFR_RNDN);
+		mpfr_mul(t, t, dp, MPFR_RNDN);
+		mpfr_mul(t, t, dp, MPFR_RNDN);
+		mpfr_ui_div(out->w.at(i), 2, t, MPFR_RNDN);
+	}
+	if (n % 2)
+	{
+		mpfr_set_zero(x, 1);
+		legendre(n, x, p, dp);
+		mpfr_sqr(t, dp, MPFR_RNDN);
+		mpfr_ui_div(out->center.ptr(), 2, t, MPFR_RNDN);
+	}
+	mpfr_clears(x, p, dp, t, (mpfr_ptr) nullptr);
+	return out;
+}
+
+// points t = j 2^-level, j odd past level 0, of x = tanh(pi/2 sinh(t)),
+// w = pi/2 cosh(t) / cosh(pi/2 sinh(t))^2, up to 1 - x = 2^-precision
+std::shared_ptr<Quadrature::Nodes> Quadrature::tanhSinh(int level, prec_t precision)
+{
+	double h = std::ldexp(1.0, -level);
+	double limit = std::asinh((precision + 1) * std::log(2.0) / M_PI);
+	int step = level ? 2 : 1;
+	size_t count = 0;
+	for (int j = 1; j * h < limit; j += step)
+		count++;
+
+	auto out = std::make_shared<Nodes>(count, precision);
+	prec_t work = precision + 16;
+	mpfr_t halfPi, t, u, ch, cu;
+	mpfr_inits2(work, halfPi, t, u, ch, cu, (mpfr_ptr) nullptr);
+	Constants::evaluate("pi", halfPi, MPFR_RNDN);
+	mpfr_div_2ui(halfPi, halfPi, 1, MPFR_RNDN);
+	if (!level)
+		mpfr_set(out->center.ptr(), halfPi, MPFR_RNDN);
+	for (size_t i = 0; i < count; i++)
+	{
+		mpfr_set_ui(t, 1 + i * step, MPFR_RNDN);
+		mpfr_div_2ui(t, t, level, MPFR_RNDN);
+		mpfr_sinh_cosh(u, ch, t, MPFR_RNDN);
+		mpfr_mul(u, u, halfPi, MPFR_RNDN);
+		mpfr_tanh(out->x.at(i), u, MPFR_RNDN);
+		mpfr_cosh(cu, u, MPFR_RNDN);
+		// 1 - tanh(u) = exp(-u) / cosh(u), without cancellation
+		mpfr_neg(u, u, MPFR_RNDN);
+		mpfr_exp(u, u, MPFR_RNDN);
+		mpfr_div(out->c.at(i), u, cu, MPFR_RNDN);
+		mpfr_mul(ch, ch, halfPi, MPFR_RNDN);
+		mpfr_sqr(cu, cu, MPFR_RNDN);
+		mpfr_div(out->w.at(i), ch, cu, MPFR_RNDN);
+	}
+	mpfr_clears(halfPi, t, u, ch, cu, (mpfr_ptr) nullptr);
+	return out;
+}
+
+void Quadrature::evaluate(val f, const FloatArray &xs, FloatArray &ys)
+{
+	if (f.instanceof(val::module_property("Formula")))
+	{
+		Formula &formula = f.as<Formula &>();
+		for (size_t i = 0; i < xs.size(); i++)
+		{
+			mpfr_srcptr x = xs.at(i);
+			formula.evaluate(&x, ys.at(i), MPFR_RNDN);
+		}
+		return;
+	}
+	// the callback gets arrays owned by JS, deleted once copied back
+	val FloatArrayClass = val::module_property("FloatArray");
+	val jsXs = FloatArrayClass.new_(xs.size(), mpfr_get_prec(xs.at(0)));
+	val jsYs = FloatArrayClass.new_(ys.size(), mpfr_get_prec(ys.at(0)));
+	FloatArray &inputs = jsXs.as<FloatArray &>();
+	for (size_t i = 0; i < xs.size(); i++)
+		mpfr_set(inputs.at(i), xs.at(i), MPFR_RNDN);
+	f(jsXs, jsYs);
+	const FloatArray &outputs = jsYs.as<const FloatArray &>();
+	for (size_t i = 0; i < ys.size(); i++)
+		mpfr_set(ys.at(i), outputs.at(i), MPFR_RNDN);
+	jsXs.call<void>("delete");
+	jsYs.call<void>("delete");
+}
+
+// a Formula integrand is evaluated with a single argument
+static bool integrand(val f)
+{
+	if (!f.instanceof(val::module_property("Formula")))
+		return true;
+	const Formula &formula = f.as<const Formula &>();
+	if (!formula.isValid())
+	{
+		std::cerr << "error: formula " << formula.getError() << std::endl;
+		return false;
+	}
+	if (formula.getVariableCount() != 1)
+	{
+		std::cerr << "error: integrand formula has " << formula.getVariableCount() << " variables, expects 1" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+Float Quadrature::integrate(val f, val a, val b)
+{
+	if (!integrand(f))
+		return Float(precision);
+	Float A(precision + GUARD), B(precision + GUARD);
+	A.set(a);
+	B.set(b);
+	return integrate([&f](const FloatArray &xs, FloatArray &ys) { evaluate(f, xs, ys); }, A.ptr(), B.ptr());
+}
+
+Float Quadrature::integrate(val f, val a, val b, Context &context)
+{
+	if (!integrand(f))
+		return Float(precision);
+	Context::Scope scope(context);
+	Float A(precision + GUARD), B(precision + GUARD);
+	A.set(a);
+	B.set(b);
+	return integrate([&f](const FloatArray &xs, FloatArray &ys) { evaluate(f, xs, ys); }, A.ptr(), B.ptr(),
+					 (Float::rnd_t)context.getRounding());
+}
+
+Float Quadrature::integrate(const sampler_t &f, mpfr_srcptr a, mpfr_srcptr b)
+{
+	return integrate(f, a, b, MPFR_RNDN);
+}
+
+Float Quadrature::integrate(const sampler_t &f, mpfr_srcptr a, mpfr_srcptr b, Float::rnd_t rnd)
+{
+	Trace::Span span("Quadrature.integrate", precision);
+	prec_t work = precision + GUARD;
+	Float A(work), B(work), out(precision);
+	mpfr_set(A.ptr(), a, MPFR_RNDN);
+	mpfr_set(B.ptr(), b, MPFR_RNDN);
+	if (!mpfr_number_p(A.ptr()) || !mpfr_number_p(B.ptr()))
+	{
+		std::cerr << "error: integration bounds must be finite" << std::endl;
+		return out;
+	}
+
+	Float half(work), mid(work), sum(work), q(work), previous(work), term(work);
+	// largest |f| sampled, times b - a it bounds the integral's terms: the
+	// absolute tolerance for integrals that cancel to zero
+	Float largest(53, 0);
+	mpfr_sub(half.ptr(), B.ptr(), A.ptr(), MPFR_RNDN);
+	mpfr_div_2ui(half.ptr(), half.ptr(), 1, MPFR_RNDN);
+	mpfr_add(mid.ptr(), A.ptr(), B.ptr(), MPFR_RNDN);
+	mpfr_div_2ui(mid.ptr(), mid.ptr(), 1, MPFR_RNDN);
+	mpfr_set_zero(sum.ptr(), 1);
+	mpfr_set_inf(error.ptr(), 1);
+
+	for (levels = 0; levels <= maxLevel;)
+	{
+		std::shared_ptr<const Nodes> rule = nodes(this->rule, levels, work);
+		size_t m = rule->x.size();
+		bool center = !mpfr_zero_p(rule->center.ptr());
+		FloatArray xs(2 * m + center, work), ys(2 * m + center, work);
+		for (size_t i = 0; i < m; i++)
+		{
+			// b - (b - a)/2 (1 - x) and a + (b - a)/2 (1 - x), exact near the ends
+			mpfr_mul(term.ptr(), half.ptr(), rule->c.at(i), MPFR_RNDN);
+			mpfr_sub(xs.at(2 * i), B.ptr(), term.ptr(), MPFR_RNDN);
+			mpfr_add(xs.at(2 * i + 1), A.ptr(), term.ptr(), MPFR_RNDN);
+		}
+		if (center)
+			mpfr_set(xs.at(2 * m), mid.ptr(), MPFR_RNDN);
+		f(xs, ys);
+
+		// samples landing on an end point are dropped, the weights there are
+		// below the precision and the integrand may be singular
+		mpfr_set_zero(q.ptr(), 1);
+		for (size_t i = 0; i < 2 * m + center; i++)
+		{
+			if (mpfr_equal_p(xs.at(i), A.ptr()) || mpfr_equal_p(xs.at(i), B.ptr()))
+				continue;
+			mpfr_srcptr w = i < 2 * m ? rule->w.at(i / 2) : rule->center.ptr();
+			if (mpfr_cmpabs(ys.at(i), largest.ptr()) > 0)
+				mpfr_abs(largest.ptr(), ys.at(i), MPFR_RNDU);
+			mpfr_mul(term.ptr(), ys.at(i), w, MPFR_RNDN);
+			mpfr_add(q.ptr(), q.ptr(), term.ptr(), MPFR_RNDN);
+		}
+		if (this->rule == TanhSinh)
+		{
+			// S_k = S_k-1 / 2 + 2^-k (new points)
+			mpfr_div_2ui(sum.ptr(), sum.ptr(), 1, MPFR_RNDN);
+			mpfr_div_2ui(q.ptr(), q.ptr(), levels, MPFR_RNDN);
+			mpfr_add(sum.ptr(), sum.ptr(), q.ptr(), MPFR_RNDN);
+			mpfr_set(q.ptr(), sum.ptr(), MPFR_RNDN);
+		}
+		mpfr_mul(q.ptr(), q.ptr(), half.ptr(), MPFR_RNDN);
+
+		bool done = false;
+		if (levels++)
+		{
+			mpfr_sub(term.ptr(), q.ptr(), previous.ptr(), MPFR_RNDN);
+			mpfr_abs(term.ptr(), term.ptr(), MPFR_RNDN);
+			mpfr_set(error.ptr(), term.ptr(), MPFR_RNDU);
+			// converged when the difference is below the last bit of the target,
+			// or of (b - a) max |f| when the integral is much smaller than that
+			done = mpfr_zero_p(term.ptr()) || !mpfr_number_p(term.ptr()) ||
+				   (!mpfr_zero_p(q.ptr()) && mpfr_get_exp(term.ptr()) <= mpfr_get_exp(q.ptr()) - (mpfr_exp_t)precision) ||
+				   (mpfr_number_p(largest.ptr()) && !mpfr_zero_p(largest.ptr()) &&
+					mpfr_get_exp(term.ptr()) <= mpfr_get_exp(largest.ptr()) + mpfr_get_exp(half.ptr()) + 1 - (mpfr_exp_t)precision);
+		}
+		mpfr_swap(previous.ptr(), q.ptr());
+		if (done)
+			break;
+	}
+	out.setRounding(rnd);
+	mpfr_set(out.ptr(), previous.ptr(), rnd);
+	return out;
+}
@@ -0,0 +1,145 @@
+#include <mpfr.h>
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+#include "RootFinder.hpp"
+#include "FloatArray.hpp"
+#include "Formula.hpp"
+#include "Trace.hpp"
+
+// bits kept above the target precision while iterating
+static const RootFinder::prec_t GUARD = 16;
+
+RootFinder::RootFinder(prec_t precision) : precision(precision) {}
+
+RootFinder::prec_t RootFinder::getPrecision() const { return precision; }
+RootFinder::builder_pattern RootFinder::setPrecision(prec_t precision) { this->precision = precision; }
+int RootFinder::getRounding() const { return rounding; }
+RootFinder::builder_pattern RootFinder::setRounding(int mode) { rounding = static_cast<Float::rnd_t>(mode); }
+int RootFinder::getMaxIterations() const { return maxIterations; }
+RootFinder::builder_pattern RootFinder::setMaxIterations(int n) { maxIterations = n; }
+
+// statistics of the last solve
+int RootFinder::getIterations() const { return iterations; }
+bool RootFinder::isConverged() const { return converged; }
+
+// f and f' are evaluated with a single argument
+static bool univariate(const Formula &formula)
+{
+	if (!formula.isValid())
+	{
+		std::cerr << "error: formula " << formula.getError() << std::endl;
+		return false;
+	}
+	if (formula.getVariableCount() != 1)
+	{
+		std::cerr << "error: root finder formula has " << formula.getVariableCount() << " variables, expects 1" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+Float RootFinder::solve(val f, val df, val guess)
+{
+	if (f.instanceof(val::module_property("Formula")))
+	{
+		iterations = 0;
+		converged = false;
+		if (!df.instanceof(val::module_property("Formula")))
+		{
+			std::cerr << "error: the derivative of a Formula must be a Formula" << std::endl;
+			return Float(precision);
+		}
+		Formula &fn = f.as<Formula &>(), &dfn = df.as<Formula &>();
+		if (!univariate(fn) || !univariate(dfn))
+			return Float(precision);
+		Float x0(53);
+		x0.set(guess);
+		return newton([&](const Float &x, Float &y, Float &dy) {
+			mpfr_srcptr args = x.ptr();
+			fn.evaluate(&args, y.ptr(), MPFR_RNDN);
+			dfn.evaluate(&args, dy.ptr(), MPFR_RNDN);
+		}, x0);
+	}
+	Float x0(53);
+	x0.set(guess);
+	// the callback gets Floats owned by JS, deleted once copied back
+	return newton([&](const Float &x, Float &y, Float &dy) {
+		val FloatClass = val::module_property("Float");
+		val jsX = FloatClass.new_(x.getPrecision()), jsY = FloatClass.new_(y.getPrecision()), jsDy = FloatClass.new_(dy.getPrecision());
+		mpfr_set(jsX.as<Float &>().ptr(), x.ptr(), MPFR_RNDN);
+		f(jsX, jsY, jsDy);
+		mpfr_set(y.ptr(), jsY.as<const Float &>().ptr(), MPFR_RNDN);
+		mpfr_set(dy.ptr(), jsDy.as<const Float &>().ptr(), MPFR_RNDN);
+		jsX.call<void>("delete");
+		jsY.call<void>("delete");
+		jsDy.call<void>("delete");
+	}, x0);
+}
+
+Float RootFinder::polynomial(val coefficients, val guess)
+{
+	Float x0(53);
+	x0.set(guess);
+	bool native = coefficients.instanceof(val::module_property("FloatArray"));
+	FloatArray converted = native ? FloatArray(0, MPFR_PREC_MIN) : FloatArray::from(coefficients, precision + GUARD);
+	const FloatArray *c = native ? &coefficients.as<const FloatArray &>() : &converted;
+	// Horner on p and p'
+	return newton([c](const Float &x, Float &y, Float &dy) {
+		mpfr_set_zero(y.ptr(), 1);
+		mpfr_set_zero(dy.ptr(), 1);
+		for (size_t i = c->size(); i-- > 0;)
+		{
+			mpfr_mul(dy.ptr(), dy.ptr(), x.ptr(), MPFR_RNDN);
+			mpfr_add(dy.ptr(), dy.ptr(), y.ptr(), MPFR_RNDN);
+			mpfr_mul(y.ptr(), y.ptr(), x.ptr(), MPFR_RNDN);
+			mpfr_add(y.ptr(), y.ptr(), c->at(i), MPFR_RNDN);
+		}
+	}, x0);
+}
+
+Float RootFinder::newton(const function_t &f, const Float &guess)
+{
+	Trace::Span span("RootFinder.newton", precision);
+	// precisions from the target down to double, used in increasing order
+	prec_t work = precision + GUARD;
+	std::vector<prec_t> schedule;
+	for (prec_t q = work; q > 64; q = q / 2 + GUARD)
+		schedule.push_back(q);
+	std::reverse(schedule.begin(), schedule.end());
+
+	Float x(guess);
+	iterations = 0;
+	converged = false;
+	size_t stage = 0;
+	while (iterations < maxIterations)
+	{
+		prec_t q = stage < schedule.size() ? schedule[stage++] : work;
+		if ((prec_t)x.getPrecision() < q)
+			Float::op_prec_round(x, q);
+		Float y(q), dy(q), dx(q);
+		f(x, y, dy);
+		mpfr_div(dx.ptr(), y.ptr(), dy.ptr(), MPFR_RNDN);
+		mpfr_sub(x.ptr(), x.ptr(), dx.ptr(), MPFR_RNDN);
+		iterations++;
+		if (!mpfr_number_p(x.ptr()))
+			break;
+		if (q < work)
+			continue;
+		// the new iterate is at least as close as the correction was
+		Float::exp_t err = mpfr_zero_p(dx.ptr()) ? q - 1 : x.getExponent() - dx.getExponent();
+		if (Float::op_can_round(x, err, MPFR_RNDN, rounding, precision + (rounding == MPFR_RNDN)))
+		{
+			converged = true;
+			break;
+		}
+	}
+	Float out(precision);
+	out.setRounding(rounding);
+	mpfr_set(out.ptr(), x.ptr(), rounding);
+	return out;
+}
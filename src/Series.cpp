@@ -0,0 +1,281 @@
+#include <mpfr.h>
+#include <gmp.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+#include "Series.hpp"
+#include "Trace.hpp"
+
+SeriesRange::SeriesRange(unsigned long begin, unsigned long end) : begin(begin), end(end)
+{
+	mpz_init(&P);
+	mpz_init(&Q);
+	mpz_init(&T);
+}
+
+SeriesRange::SeriesRange(const SeriesRange &other) : begin(other.begin), end(other.end)
+{
+	mpz_init_set(&P, &other.P);
+	mpz_init_set(&Q, &other.Q);
+	mpz_init_set(&T, &other.T);
+}
+
+SeriesRange::~SeriesRange()
+{
+	mpz_clear(&P);
+	mpz_clear(&Q);
+	mpz_clear(&T);
+}
+
+unsigned long SeriesRange::getBegin() const { return begin; }
+unsigned long SeriesRange::getEnd() const { return end; }
+
+std::string SeriesRange::serialize() const
+{
+	std::string out = std::to_string(begin) + ":" + std::to_string(end);
+	for (mpz_srcptr z : {&P, &Q, &T})
+	{
+		char *digits = mpz_get_str(nullptr, 32, z);
+		out += ":";
+		out += digits;
+		void (*freefunc)(void *, size_t);
+		mp_get_memory_functions(nullptr, nullptr, &freefunc);
+		freefunc(digits, std::strlen(digits) + 1);
+	}
+	return out;
+}
+
+SeriesRange SeriesRange::deserialize(const std::string &text)
+{
+	std::vector<std::string> fields;
+	size_t start = 0;
+	for (size_t colon; (colon = text.find(':', start)) != std::string::npos; start = colon + 1)
+		fields.push_back(text.substr(start, colon - start));
+	fields.push_back(text.substr(start));
+	if (fields.size() != 5)
+	{
+		std::cerr << "error: malformed series range" << std::endl;
+		return SeriesRange(0, 0);
+	}
+	SeriesRange out(std::stoul(fields[0]), std::stoul(fields[1]));
+	mpz_set_str(&out.P, fields[2].c_str(), 32);
+	mpz_set_str(&out.Q, fields[3].c_str(), 32);
+	mpz_set_str(&out.T, fields[4].c_str(), 32);
+	return out;
+}
+
+Series::Series(val p, val q, val a) : p(coefficients(p)), q(coefficients(q)), a(coefficients(a)) {}
+
+Series::~Series()
+{
+	for (std::vector<__mpz_struct> *c : {&p, &q, &a})
+		for (__mpz_struct &z : *c)
+			mpz_clear(&z);
+}
+
+// numbers or decimal strings, lowest degree first
+std::vector<__mpz_struct> Series::coefficients(val v)
+{
+	int length = v["length"].as<int>();
+	std::vector<__mpz_struct> out(length);
+	for (int i = 0; i < length; i++)
+	{
+		mpz_init(&out[i]);
+		val c = v[i];
+		if (c.isNumber())
+			mpz_set_d(&out[i], c.as<double>());
+		else
+			mpz_set_str(&out[i], c.as<std::string>().c_str(), 10);
+	}
+	return out;
+}
+
+void Series::polynomial(mpz_ptr out, const std::vector<__mpz_struct> &c, unsigned long n)
+{
+	mpz_set_ui(out, 0);
+	for (size_t i = c.size(); i-- > 0;)
+	{
+		mpz_mul_ui(out, out, n);
+		mpz_add(out, out, &c[i]);
+	}
+}
+
+double Series::logPolynomial(const std::vector<__mpz_struct> &c, unsigned long n)
+{
+	double v = 0;
+	for (size_t i = c.size(); i-- > 0;)
+		v = v * n + mpz_get_d(&c[i]);
+	return std::log2(std::fabs(v));
+}
+
+// log2 of sum |c_i| n^i, an increasing bound on |c(n)|
+double Series::logBound(const std::vector<__mpz_struct> &c, unsigned long n)
+{
+	double v = 0;
+	for (size_t i = c.size(); i-- > 0;)
+		v = v * n + std::fabs(mpz_get_d(&c[i]));
+	return std::log2(v);
+}
+
+unsigned long Series::terms(prec_t precision) const
+{
+	double largest, tail;
+	return truncation(precision, largest, tail);
+}
+
+unsigned long Series::truncation(prec_t precision, double &largest, double &tail) const
+{
+	// log2 of the terms in double, with a(n) replaced by its bound A(n), until
+	// they are below the largest one by the precision and the next ones
+	// decrease by at least half: the tail from n is then below 2 A(n) |prod|
+	// as long as |p(k) / q(k)| keeps decreasing
+	double product = 0;
+	int degree = std::max<int>(0, a.size() - 1);
+	largest = tail = -std::numeric_limits<double>::infinity();
+	for (unsigned long n = 0; n < (1ul << 31); n++)
+	{
+		double ratio = 0;
+		if (n)
+		{
+			ratio = logPolynomial(p, n) - logPolynomial(q, n);
+			if (ratio == -std::numeric_limits<double>::infinity())
+				return n;
+			product += ratio;
+		}
+		double term = product + logBound(a, n);
+		largest = std::max(largest, term);
+		// bound on the ratio of the next terms
+		double step = logPolynomial(p, n + 1) - logPolynomial(q, n + 1) + (n ? degree * std::log2(1 + 1.0 / n) : 0);
+		if (n && largest == -std::numeric_limits<double>::infinity())
+			return n;
+		if (n && step <= -1 && term < largest - precision - 2)
+		{
+			tail = term + 1;
+			return n;
+		}
+	}
+	std::cerr << "error: series does not converge" << std::endl;
+	return 1ul << 31;
+}
+
+void Series::split(unsigned long begin, unsigned long end, mpz_ptr P, mpz_ptr Q, mpz_ptr T) const
+{
+	if (end - begin == 1)
+	{
+		if (begin)
+		{
+			polynomial(P, p, begin);
+			polynomial(Q, q, begin);
+		}
+		else
+		{
+			mpz_set_ui(P, 1);
+			mpz_set_ui(Q, 1);
+		}
+		polynomial(T, a, begin);
+		mpz_mul(T, T, P);
+		return;
+	}
+	unsigned long middle = begin + (end - begin) / 2;
+	mpz_t P2, Q2, T2;
+	mpz_inits(P2, Q2, T2, nullptr);
+	split(begin, middle, P, Q, T);
+	split(middle, end, P2, Q2, T2);
+	// T = T1 Q2 + P1 T2, P = P1 P2, Q = Q1 Q2
+	mpz_mul(T, T, Q2);
+	mpz_mul(T2, T2, P);
+	mpz_add(T, T, T2);
+	mpz_mul(P, P, P2);
+	mpz_mul(Q, Q, Q2);
+	mpz_clears(P2, Q2, T2, nullptr);
+}
+
+SeriesRange Series::range(unsigned long begin, unsigned long end) const
+{
+	SeriesRange out(begin, end);
+	if (end <= begin)
+	{
+		mpz_set_ui(&out.P, 1);
+		mpz_set_ui(&out.Q, 1);
+		return out;
+	}
+	split(begin, end, &out.P, &out.Q, &out.T);
+	return out;
+}
+
+SeriesRange Series::combine(const SeriesRange &left, const SeriesRange &right)
+{
+	SeriesRange out(left.begin, right.end);
+	if (left.end != right.begin)
+		std::cerr << "error: series ranges are not adjacent" << std::endl;
+	mpz_mul(&out.T, &left.T, &right.Q);
+	mpz_addmul(&out.T, &left.P, &right.T);
+	mpz_mul(&out.P, &left.P, &right.P);
+	mpz_mul(&out.Q, &left.Q, &right.Q);
+	return out;
+}
+
+// T / Q correctly rounded: both are set exactly before the division
+Float Series::value(const SeriesRange &range, prec_t precision, int rounding)
+{
+	Float out(precision);
+	out.setRounding(rounding);
+	mpfr_t t, q;
+	mpfr_init2(t, std::max<prec_t>(MPFR_PREC_MIN, mpz_sizeinbase(&range.T, 2)));
+	mpfr_init2(q, std::max<prec_t>(MPFR_PREC_MIN, mpz_sizeinbase(&range.Q, 2)));
+	mpfr_set_z(t, &range.T, MPFR_RNDN);
+	mpfr_set_z(q, &range.Q, MPFR_RNDN);
+	mpfr_div(out.ptr(), t, q, (mpfr_rnd_t)rounding);
+	mpfr_clear(t);
+	mpfr_clear(q);
+	return out;
+}
+
+Float Series::evaluate(prec_t precision, int rounding)
+{
+	Trace::Span span("Series.evaluate", precision);
+	// guard bits of this call, grown when the rounding cannot be decided
+	prec_t extra = guard;
+	for (int attempt = 0; attempt < 8; attempt++)
+	{
+		prec_t work = precision + extra;
+		double largest, tail;
+		unsigned long n = truncation(work, largest, tail);
+		SeriesRange sum = range(0, n);
+		Float x = value(sum, work, MPFR_RNDN);
+		if (mpfr_zero_p(x.ptr()) && tail == -std::numeric_limits<double>::infinity())
+			return value(sum, precision, rounding);
+
+		// T / Q is exact before the rounding to work, the error is the tail
+		// beyond n plus that rounding, relative to the sum: the guard bits go
+		// to the cancellation between the largest term and the sum
+		Float::exp_t err = -work;
+		if (!mpfr_zero_p(x.ptr()))
+		{
+			Float::exp_t bound = x.getExponent() - work;
+			if (tail != -std::numeric_limits<double>::infinity())
+				bound = std::max<Float::exp_t>(bound, (Float::exp_t)std::ceil(tail));
+			err = x.getExponent() - bound - 1;
+			if (Float::op_can_round(x, err, MPFR_RNDN, rounding, precision + (rounding == MPFR_RNDN)))
+			{
+				Float out(precision);
+				out.setRounding(rounding);
+				mpfr_set(out.ptr(), x.ptr(), (mpfr_rnd_t)rounding);
+				return out;
+			}
+		}
+		// more bits for the cancellation seen, at least twice the guard
+		Float::exp_t lost = mpfr_zero_p(x.ptr()) ? extra : (Float::exp_t)std::ceil(largest) - x.getExponent();
+		extra = std::max<Float::exp_t>(2 * extra, lost + 2 * extra);
+		if (extra > MPFR_PREC_MAX - precision)
+			break;
+	}
+	std::cerr << "error: series cannot be rounded, too much cancellation" << std::endl;
+	return Float(precision);
+}
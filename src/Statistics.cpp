@@ -0,0 +1,419 @@
+#include <mpfr.h>
+#include <gmp.h>
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+#include "Statistics.hpp"
+#include "Accumulator.hpp"
+#include "FloatArray.hpp"
+#include "Formula.hpp"
+#include "Trace.hpp"
+
+typedef Statistics::exp_t exp_t;
+
+// exact m * 2^e
+struct Dyadic
+{
+	__mpz_struct m;
+	exp_t e = 0;
+
+	Dyadic() { mpz_init(&m); }
+	Dyadic(unsigned long n) { mpz_init_set_ui(&m, n); }
+	Dyadic(const Dyadic &) = delete;
+	Dyadic &operator=(const Dyadic &) = delete;
+	~Dyadic() { mpz_clear(&m); }
+};
+
+// r = a + b or a - b
+static void add(Dyadic &r, const Dyadic &a, const Dyadic &b, bool subtract)
+{
+	exp_t e = std::min(a.e, b.e);
+	mpz_t u, v;
+	mpz_init(u);
+	mpz_init(v);
+	mpz_mul_2exp(u, &a.m, a.e - e);
+	mpz_mul_2exp(v, &b.m, b.e - e);
+	if (subtract)
+		mpz_sub(&r.m, u, v);
+	else
+		mpz_add(&r.m, u, v);
+	r.e = e;
+	mpz_clear(u);
+	mpz_clear(v);
+}
+
+static void mul(Dyadic &r, const Dyadic &a, const Dyadic &b)
+{
+	mpz_mul(&r.m, &a.m, &b.m);
+	r.e = a.e + b.e;
+}
+
+// the only rounding, num and den are converted exactly
+static void divide(mpfr_ptr out, const Dyadic &num, const Dyadic &den, mpfr_rnd_t rnd)
+{
+	if (mpz_sgn(&den.m) == 0)
+	{
+		mpfr_set_nan(out);
+		return;
+	}
+	Float a(std::max<Float::prec_t>(MPFR_PREC_MIN, mpz_sizeinbase(&num.m, 2)));
+	Float b(std::max<Float::prec_t>(MPFR_PREC_MIN, mpz_sizeinbase(&den.m, 2)));
+	mpfr_set_z_2exp(a.ptr(), &num.m, num.e, MPFR_RNDN);
+	mpfr_set_z_2exp(b.ptr(), &den.m, den.e, MPFR_RNDN);
+	mpfr_div(out, a.ptr(), b.ptr(), rnd);
+}
+
+// Float64Array read in place, FloatArray, or array of Floats and numbers
+struct Samples
+{
+	std::vector<double> copy;
+	const double *doubles = nullptr;
+	const FloatArray *array = nullptr;
+	std::vector<Float> holder;
+	std::vector<mpfr_srcptr> floats;
+	size_t size;
+	Float scratch{53};
+
+	Samples(val v)
+	{
+		if (Accumulator::isFloat64Array(v))
+		{
+			doubles = Accumulator::doubles(v, copy);
+			size = v["length"].as<size_t>();
+		}
+		else if (v.instanceof(val::module_property("FloatArray")))
+		{
+			array = &v.as<const FloatArray &>();
+			size = array->size();
+		}
+		else
+		{
+			floats = Formula::arguments(v, holder);
+			size = floats.size();
+		}
+	}
+
+	// a double element is valid until the next call
+	mpfr_srcptr operator[](size_t i)
+	{
+		if (doubles)
+		{
+			mpfr_set_d(scratch.ptr(), doubles[i], MPFR_RNDN);
+			return scratch.ptr();
+		}
+		return array ? array->at(i) : floats[i];
+	}
+};
+
+// sum += a b (c), the product being exact
+static void addProduct(Accumulator &sum, Float &product, mpfr_srcptr a, mpfr_srcptr b, mpfr_srcptr c = nullptr)
+{
+	Float::prec_t p = mpfr_get_prec(a) + mpfr_get_prec(b);
+	mpfr_set_prec(product.ptr(), c ? p + mpfr_get_prec(c) : p);
+	mpfr_mul(product.ptr(), a, b, MPFR_RNDN);
+	if (c)
+		mpfr_mul(product.ptr(), product.ptr(), c, MPFR_RNDN);
+	sum.addFloat(product.ptr(), false);
+}
+
+static bool sameSize(const Samples &a, const Samples &b)
+{
+	if (a.size == b.size)
+		return true;
+	std::cerr << "error: samples of different size, " << a.size << " and " << b.size << std::endl;
+	return false;
+}
+
+Statistics::Statistics(prec_t precision) : precision(precision) {}
+
+Statistics::prec_t Statistics::getPrecision() const { return precision; }
+Statistics::builder_pattern Statistics::setPrecision(prec_t precision) { this->precision = precision; }
+int Statistics::getRounding() const { return rounding; }
+Statistics::builder_pattern Statistics::setRounding(int mode) { rounding = (Float::rnd_t)mode; }
+
+Float Statistics::mean(val x)
+{
+	Trace::Span span("Statistics.mean", precision);
+	Samples s(x);
+	Float out(precision);
+	Accumulator sum(precision);
+	if (s.doubles)
+		sum.addDoubles(s.doubles, s.size);
+	else
+		for (size_t i = 0; i < s.size; i++)
+			sum.addFloat(s[i], false);
+	Dyadic S, n(s.size);
+	// zeros keep the sign rules of the sum, NaN and infinities too
+	if (!sum.exact(&S.m, S.e) || mpz_sgn(&S.m) == 0)
+	{
+		sum.round(out.ptr(), rounding);
+		if (!s.size)
+			mpfr_set_nan(out.ptr());
+		return out;
+	}
+	divide(out.ptr(), S, n, rounding);
+	return out;
+}
+
+// (n sum x^2 - (sum x)^2) / (n (n - ddof))
+Float Statistics::variance(val x, int ddof)
+{
+	Trace::Span span("Statistics.variance", precision);
+	Samples s(x);
+	Float out(precision), product(MPFR_PREC_MIN);
+	Accumulator sum(precision), squares(precision);
+	if (s.doubles)
+	{
+		sum.addDoubles(s.doubles, s.size);
+		squares.addProducts(s.doubles, s.doubles, s.size);
+	}
+	else
+		for (size_t i = 0; i < s.size; i++)
+		{
+			mpfr_srcptr v = s[i];
+			sum.addFloat(v, false);
+			addProduct(squares, product, v, v);
+		}
+	Dyadic S, Q, n(s.size), d(s.size), num, den, t;
+	if ((long)s.size <= ddof || !sum.exact(&S.m, S.e) || !squares.exact(&Q.m, Q.e))
+	{
+		mpfr_set_nan(out.ptr());
+		return out;
+	}
+	mul(num, n, Q);
+	mul(t, S, S);
+	add(num, num, t, true);
+	mpz_sub_ui(&d.m, &d.m, ddof);
+	mul(den, n, d);
+	divide(out.ptr(), num, den, rounding);
+	return out;
+}
+
+// (n sum xy - sum x sum y) / (n (n - ddof))
+Float Statistics::covariance(val x, val y, int ddof)
+{
+	Trace::Span span("Statistics.covariance", precision);
+	Samples a(x), b(y);
+	Float out(precision), product(MPFR_PREC_MIN);
+	if (!sameSize(a, b) || (long)a.size <= ddof)
+	{
+		mpfr_set_nan(out.ptr());
+		return out;
+	}
+	Accumulator sumX(precision), sumY(precision), products(precision);
+	if (a.doubles && b.doubles)
+	{
+		sumX.addDoubles(a.doubles, a.size);
+		sumY.addDoubles(b.doubles, b.size);
+		products.addProducts(a.doubles, b.doubles, a.size);
+	}
+	else
+		for (size_t i = 0; i < a.size; i++)
+		{
+			mpfr_srcptr u = a[i], v = b[i];
+			sumX.addFloat(u, false);
+			sumY.addFloat(v, false);
+			addProduct(products, product, u, v);
+		}
+	Dyadic X, Y, P, n(a.size), d(a.size), num, den, t;
+	if (!sumX.exact(&X.m, X.e) || !sumY.exact(&Y.m, Y.e) || !products.exact(&P.m, P.e))
+	{
+		mpfr_set_nan(out.ptr());
+		return out;
+	}
+	mul(num, n, P);
+	mul(t, X, Y);
+	add(num, num, t, true);
+	mpz_sub_ui(&d.m, &d.m, ddof);
+	mul(den, n, d);
+	divide(out.ptr(), num, den, rounding);
+	return out;
+}
+
+// with the power sums P_j and S = P_1,
+// n^k sum (x - S/n)^k = sum_j C(k, j) n^j P_j (-S)^(k-j)
+Float Statistics::moment(val x, int k)
+{
+	Trace::Span span("Statistics.moment", precision);
+	Samples s(x);
+	Float out(precision);
+	if (k < 0 || !s.size)
+	{
+		mpfr_set_nan(out.ptr());
+		return out;
+	}
+	std::vector<std::unique_ptr<Accumulator>> sums;
+	for (int j = 0; j <= k; j++)
+		sums.emplace_back(new Accumulator(precision));
+	Float power(MPFR_PREC_MIN), next(MPFR_PREC_MIN);
+	for (size_t i = 0; i < s.size; i++)
+	{
+		mpfr_srcptr v = s[i];
+		mpfr_set_prec(power.ptr(), mpfr_get_prec(v));
+		mpfr_set(power.ptr(), v, MPFR_RNDN);
+		for (int j = 1; j <= k; j++)
+		{
+			sums[j]->addFloat(power.ptr(), false);
+			if (j == k)
+				break;
+			mpfr_set_prec(next.ptr(), mpfr_get_prec(power.ptr()) + mpfr_get_prec(v));
+			mpfr_mul(next.ptr(), power.ptr(), v, MPFR_RNDN);
+			mpfr_swap(power.ptr(), next.ptr());
+		}
+	}
+
+	Dyadic S, num, n(s.size), term, t;
+	if (k >= 1 && !sums[1]->exact(&S.m, S.e))
+	{
+		mpfr_set_nan(out.ptr());
+		return out;
+	}
+	mpz_neg(&S.m, &S.m);
+	for (int j = 0; j <= k; j++)
+	{
+		// C(k, j) n^j P_j (-S)^(k-j), P_0 = n
+		Dyadic P;
+		if (j == 0)
+			mpz_set(&P.m, &n.m);
+		else if (!sums[j]->exact(&P.m, P.e))
+		{
+			mpfr_set_nan(out.ptr());
+			return out;
+		}
+		mpz_bin_uiui(&term.m, k, j);
+		term.e = 0;
+		mpz_pow_ui(&t.m, &n.m, j);
+		t.e = 0;
+		mul(term, term, t);
+		mul(term, term, P);
+		mpz_pow_ui(&t.m, &S.m, k - j);
+		t.e = S.e * (k - j);
+		mul(term, term, t);
+		add(num, num, term, false);
+	}
+	Dyadic den;
+	mpz_pow_ui(&den.m, &n.m, k + 1);
+	divide(out.ptr(), num, den, rounding);
+	return out;
+}
+
+Float Statistics::weightedMean(val x, val w)
+{
+	Trace::Span span("Statistics.weightedMean", precision);
+	Samples a(x), b(w);
+	Float out(precision), product(MPFR_PREC_MIN);
+	if (!sameSize(a, b))
+	{
+		mpfr_set_nan(out.ptr());
+		return out;
+	}
+	Accumulator weights(precision), sum(precision);
+	if (a.doubles && b.doubles)
+	{
+		weights.addDoubles(b.doubles, b.size);
+		sum.addProducts(b.doubles, a.doubles, a.size);
+	}
+	else
+		for (size_t i = 0; i < a.size; i++)
+		{
+			mpfr_srcptr u = a[i], v = b[i];
+			weights.addFloat(v, false);
+			addProduct(sum, product, v, u);
+		}
+	Dyadic W, A;
+	if (!weights.exact(&W.m, W.e) || !sum.exact(&A.m, A.e))
+		mpfr_set_nan(out.ptr());
+	else
+		divide(out.ptr(), A, W, rounding);
+	return out;
+}
+
+// (W sum w x^2 - (sum w x)^2) / W^2
+Float Statistics::weightedVariance(val x, val w)
+{
+	Trace::Span span("Statistics.weightedVariance", precision);
+	Samples a(x), b(w);
+	Float out(precision), product(MPFR_PREC_MIN);
+	if (!sameSize(a, b))
+	{
+		mpfr_set_nan(out.ptr());
+		return out;
+	}
+	Accumulator weights(precision), sum(precision), squares(precision);
+	if (a.doubles && b.doubles)
+	{
+		weights.addDoubles(b.doubles, b.size);
+		sum.addProducts(b.doubles, a.doubles, a.size);
+	}
+	for (size_t i = 0; i < a.size; i++)
+	{
+		mpfr_srcptr u = a[i], v = b[i];
+		if (!a.doubles || !b.doubles)
+		{
+			weights.addFloat(v, false);
+			addProduct(sum, product, v, u);
+		}
+		addProduct(squares, product, v, u, u);
+	}
+	Dyadic W, A, B, num, den, t;
+	if (!weights.exact(&W.m, W.e) || !sum.exact(&A.m, A.e) || !squares.exact(&B.m, B.e))
+	{
+		mpfr_set_nan(out.ptr());
+		return out;
+	}
+	mul(num, W, B);
+	mul(t, A, A);
+	add(num, num, t, true);
+	mul(den, W, W);
+	divide(out.ptr(), num, den, rounding);
+	return out;
+}
+
+// (W sum w x y - sum w x sum w y) / W^2
+Float Statistics::weightedCovariance(val x, val y, val w)
+{
+	Trace::Span span("Statistics.weightedCovariance", precision);
+	Samples a(x), b(y), c(w);
+	Float out(precision), product(MPFR_PREC_MIN);
+	if (!sameSize(a, b) || !sameSize(a, c))
+	{
+		mpfr_set_nan(out.ptr());
+		return out;
+	}
+	Accumulator weights(precision), sumX(precision), sumY(precision), products(precision);
+	bool fast = a.doubles && b.doubles && c.doubles;
+	if (fast)
+	{
+		weights.addDoubles(c.doubles, c.size);
+		sumX.addProducts(c.doubles, a.doubles, a.size);
+		sumY.addProducts(c.doubles, b.doubles, b.size);
+	}
+	for (size_t i = 0; i < a.size; i++)
+	{
+		mpfr_srcptr u = a[i], v = b[i], q = c[i];
+		if (!fast)
+		{
+			weights.addFloat(q, false);
+			addProduct(sumX, product, q, u);
+			addProduct(sumY, product, q, v);
+		}
+		addProduct(products, product, q, u, v);
+	}
+	Dyadic W, X, Y, P, num, den, t;
+	if (!weights.exact(&W.m, W.e) || !sumX.exact(&X.m, X.e) || !sumY.exact(&Y.m, Y.e) || !products.exact(&P.m, P.e))
+	{
+		mpfr_set_nan(out.ptr());
+		return out;
+	}
+	mul(num, W, P);
+	mul(t, X, Y);
+	add(num, num, t, true);
+	mul(den, W, W);
+	divide(out.ptr(), num, den, rounding);
+	return out;
+}
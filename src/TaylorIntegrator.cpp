@@ -0,0 +1,684 @@
+#include <mpfr.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <vector>
+#include <emscripten/val.h>
+
+using namespace emscripten;
+
+#include "TaylorIntegrator.hpp"
+#include "Constants.hpp"
+#include "Trace.hpp"
+
+static const mpfr_rnd_t N = MPFR_RNDN;
+
+// bits carried past the precision through the recurrences and the steps
+static const TaylorIntegrator::prec_t GUARD = 32;
+
+TaylorIntegrator::TaylorIntegrator(val system, prec_t precision) : TaylorIntegrator(formulas(system), precision) {}
+
+TaylorIntegrator::TaylorIntegrator(const std::vector<const Formula *> &system, prec_t precision)
+	: precision(precision), working(precision + GUARD), components(system.size()), start(precision + GUARD), end(precision + GUARD)
+{
+	add(Time);
+	for (size_t i = 0; i < components; i++)
+		add(State);
+	for (size_t i = 0; i < components && error.empty(); i++)
+	{
+		const Formula &formula = *system[i];
+		if (!formula.isValid())
+			error = "component " + std::to_string(i) + ": " + formula.getError();
+		else if (formula.getVariableCount() != (int)components + 1)
+			error = "component " + std::to_string(i) + " has " + std::to_string(formula.getVariableCount()) + " variables, expected t and " + std::to_string(components) + " unknowns";
+		else
+			outputs.push_back(lower(formula));
+	}
+	if (!error.empty())
+		std::cerr << "error: " << error << std::endl;
+}
+
+std::vector<const Formula *> TaylorIntegrator::formulas(val system)
+{
+	std::vector<const Formula *> out(system["length"].as<size_t>());
+	for (size_t i = 0; i < out.size(); i++)
+		out[i] = &system[i].as<const Formula &>();
+	return out;
+}
+
+bool TaylorIntegrator::isValid() const { return error.empty(); }
+std::string TaylorIntegrator::getError() const { return error; }
+TaylorIntegrator::prec_t TaylorIntegrator::getPrecision() const { return precision; }
+int TaylorIntegrator::getOrder() const { return order; }
+TaylorIntegrator::builder_pattern TaylorIntegrator::setOrder(int order) { this->order = std::max(order, 0); }
+int TaylorIntegrator::getMaxSteps() const { return maxSteps; }
+TaylorIntegrator::builder_pattern TaylorIntegrator::setMaxSteps(int n) { maxSteps = n; }
+bool TaylorIntegrator::getDenseOutput() const { return dense; }
+TaylorIntegrator::builder_pattern TaylorIntegrator::setDenseOutput(bool dense) { this->dense = dense; }
+int TaylorIntegrator::getSteps() const { return steps; }
+
+// lowering
+
+int TaylorIntegrator::add(Kind kind, int a, int b)
+{
+	nodes.emplace_back();
+	Node &node = nodes.back();
+	node.kind = kind;
+	node.a = a;
+	node.b = b;
+	mpfr_set_prec(node.value.ptr(), working);
+	return nodes.size() - 1;
+}
+
+int TaylorIntegrator::constant(double v)
+{
+	int i = add(Constant);
+	mpfr_set_d(nodes[i].value.ptr(), v, N);
+	return i;
+}
+
+int TaylorIntegrator::integral(int a, int g, unary_t start)
+{
+	int i = add(Integral, a, g);
+	nodes[i].start = start;
+	return i;
+}
+
+int TaylorIntegrator::lower(const Formula &formula)
+{
+	const std::vector<Formula::Instruction> &tape = formula.getTape();
+	std::vector<int> slots(formula.getDepth() + 1, -1);
+	for (const Formula::Instruction &ins : tape)
+	{
+		int a = slots[ins.slot], b = slots[ins.slot + 1], r = -1;
+		switch (ins.op)
+		{
+		case Formula::Variable:
+			// node 0 is t, node j is yj
+			r = ins.arg;
+			break;
+		case Formula::Constant:
+			r = add(Constant);
+			formula.constant(ins.arg, nodes[r].value.ptr());
+			break;
+		case Formula::Neg:
+			r = add(Neg, a);
+			break;
+		case Formula::Add:
+			r = add(Add, a, b);
+			break;
+		case Formula::Sub:
+			r = add(Sub, a, b);
+			break;
+		case Formula::Mul:
+			r = add(Mul, a, b);
+			break;
+		case Formula::Div:
+			r = add(Div, a, b);
+			break;
+		case Formula::Pow:
+			r = call2("pow", a, b);
+			break;
+		case Formula::PowInt:
+		{
+			// by squaring, so a zero base is fine for positive exponents
+			unsigned long n = ins.arg < 0 ? -ins.arg : ins.arg;
+			int base = a;
+			for (r = n ? -1 : constant(1); n; n >>= 1)
+			{
+				if (n & 1)
+					r = r < 0 ? base : add(Mul, r, base);
+				if (n > 1)
+					base = add(Mul, base, base);
+			}
+			if (ins.arg < 0)
+				r = add(Div, constant(1), r);
+			break;
+		}
+		case Formula::Call:
+			r = call(Formula::functions[ins.arg].name, a);
+			break;
+		case Formula::Call2:
+			r = call2(Formula::functions2[ins.arg].name, a, b);
+			break;
+		}
+		if (r < 0)
+			return -1;
+		slots[ins.slot] = r;
+	}
+	return slots[0];
+}
+
+int TaylorIntegrator::call(const std::string &name, int a)
+{
+	auto pair = [&](Kind first, Kind second, bool wantFirst) {
+		int s = add(first, a), c = add(second, a);
+		nodes[s].b = c;
+		nodes[c].b = s;
+		return wantFirst ? s : c;
+	};
+	auto square = [&]() { return add(Mul, a, a); };
+	auto power = [&](int x, int num, int den) {
+		int i = add(Power, x);
+		mpfr_set_si(nodes[i].value.ptr(), num, N);
+		mpfr_div_si(nodes[i].value.ptr(), nodes[i].value.ptr(), den, N);
+		return i;
+	};
+	auto named = [&](const char *constant) {
+		int i = add(Constant);
+		Constants::evaluate(constant, nodes[i].value.ptr(), N);
+		return i;
+	};
+	auto ln10 = [&]() {
+		int i = add(Constant);
+		mpfr_log_ui(nodes[i].value.ptr(), 10, N);
+		return i;
+	};
+	// u' = a' g(u), g built after u
+	auto implicit = [&](unary_t start, Kind op, int one) {
+		int u = integral(a, -1, start);
+		int g = add(op, one, add(Mul, u, u));
+		nodes[u].b = g;
+		return u;
+	};
+	// 2 exp(-a^2) / sqrt(pi)
+	auto gauss = [&]() {
+		int c = named("pi");
+		mpfr_rec_sqrt(nodes[c].value.ptr(), nodes[c].value.ptr(), N);
+		mpfr_mul_2ui(nodes[c].value.ptr(), nodes[c].value.ptr(), 1, N);
+		return add(Mul, c, add(Exp, add(Neg, square())));
+	};
+	auto step = [&](int x, unary_t start) {
+		int i = add(Step, x);
+		nodes[i].start = start;
+		return i;
+	};
+
+	if (name == "sqrt")
+		return add(Sqrt, a);
+	if (name == "rec_sqrt")
+		return add(Div, constant(1), add(Sqrt, a));
+	if (name == "cbrt")
+		return power(a, 1, 3);
+	if (name == "abs")
+		return add(Abs, a);
+	if (name == "exp")
+		return add(Exp, a);
+	if (name == "exp2")
+		return add(Exp, add(Mul, named("log2"), a));
+	if (name == "exp10")
+		return add(Exp, add(Mul, ln10(), a));
+	if (name == "expm1")
+		return integral(a, add(Exp, a), mpfr_expm1);
+	if (name == "log")
+		return add(Log, a);
+	if (name == "log2")
+		return add(Div, add(Log, a), named("log2"));
+	if (name == "log10")
+		return add(Div, add(Log, a), ln10());
+	if (name == "log1p")
+		return integral(a, add(Div, constant(1), add(Add, constant(1), a)), mpfr_log1p);
+	if (name == "sin" || name == "cos")
+		return pair(Sin, Cos, name == "sin");
+	if (name == "tan")
+		return implicit(mpfr_tan, Add, constant(1));
+	if (name == "sec")
+		return add(Div, constant(1), pair(Sin, Cos, false));
+	if (name == "csc")
+		return add(Div, constant(1), pair(Sin, Cos, true));
+	if (name == "cot")
+	{
+		int s = pair(Sin, Cos, true);
+		return add(Div, nodes[s].b, s);
+	}
+	if (name == "asin")
+		return integral(a, power(add(Sub, constant(1), square()), -1, 2), mpfr_asin);
+	if (name == "acos")
+		return integral(a, add(Neg, power(add(Sub, constant(1), square()), -1, 2)), mpfr_acos);
+	if (name == "atan")
+		return integral(a, add(Div, constant(1), add(Add, constant(1), square())), mpfr_atan);
+	if (name == "sinh" || name == "cosh")
+		return pair(Sinh, Cosh, name == "sinh");
+	if (name == "tanh")
+		return implicit(mpfr_tanh, Sub, constant(1));
+	if (name == "sech")
+		return add(Div, constant(1), pair(Sinh, Cosh, false));
+	if (name == "csch")
+		return add(Div, constant(1), pair(Sinh, Cosh, true));
+	if (name == "coth")
+	{
+		int s = pair(Sinh, Cosh, true);
+		return add(Div, nodes[s].b, s);
+	}
+	if (name == "asinh")
+		return integral(a, power(add(Add, square(), constant(1)), -1, 2), mpfr_asinh);
+	if (name == "acosh")
+		return integral(a, power(add(Sub, square(), constant(1)), -1, 2), mpfr_acosh);
+	if (name == "atanh")
+		return integral(a, add(Div, constant(1), add(Sub, constant(1), square())), mpfr_atanh);
+	if (name == "erf")
+		return integral(a, gauss(), mpfr_erf);
+	if (name == "erfc")
+		return integral(a, add(Neg, gauss()), mpfr_erfc);
+	if (name == "eint")
+		return integral(a, add(Div, add(Exp, a), a), mpfr_eint);
+	if (name == "li2")
+		return integral(a, add(Neg, add(Div, add(Log, add(Sub, constant(1), a)), a)), mpfr_li2);
+	if (name == "floor")
+		return step(a, mpfr_rint_floor);
+	if (name == "ceil")
+		return step(a, mpfr_rint_ceil);
+	if (name == "trunc")
+		return step(a, mpfr_rint_trunc);
+	if (name == "frac")
+		return add(Sub, a, step(a, mpfr_rint_trunc));
+	error = "no Taylor recurrence for " + name;
+	return -1;
+}
+
+int TaylorIntegrator::call2(const std::string &name, int a, int b)
+{
+	if (name == "pow")
+		return add(Exp, add(Mul, b, add(Log, a)));
+	if (name == "hypot")
+		return add(Sqrt, add(Add, add(Mul, a, a), add(Mul, b, b)));
+	if (name == "min")
+		return add(Min, a, b);
+	if (name == "max")
+		return add(Max, a, b);
+	if (name == "fmod")
+	{
+		int step = add(Step, add(Div, a, b));
+		nodes[step].start = mpfr_rint_trunc;
+		return add(Sub, a, add(Mul, step, b));
+	}
+	if (name == "atan2")
+	{
+		// atan2(a, b)' = (b a' - a b') / (a^2 + b^2)
+		int r2 = add(Add, add(Mul, a, a), add(Mul, b, b));
+		int u = add(Integral, a, add(Div, b, r2));
+		nodes[u].c = b;
+		nodes[u].d = add(Neg, add(Div, a, r2));
+		nodes[u].start2 = mpfr_atan2;
+		return u;
+	}
+	error = "no Taylor recurrence for " + name;
+	return -1;
+}
+
+// series
+
+// about -log(2^-precision) / 2, Jorba and Zou
+int TaylorIntegrator::effectiveOrder() const
+{
+	return order ? order : std::max<int>(4, std::ceil(precision * std::log(2.0) / 2) + 1);
+}
+
+void TaylorIntegrator::coefficient(Node &node, int k, Float &sum, Float &term)
+{
+	mpfr_ptr u = node.series[k].ptr();
+	auto at = [&](int i, int j) { return nodes[i].series[j].ptr(); };
+	// sum = sum_{j=from}^{to} (j or 1) x_j y_{k-j}
+	auto convolve = [&](int x, int y, int from, int to, bool weighted) {
+		mpfr_set_zero(sum.ptr(), 1);
+		for (int j = from; j <= to; j++)
+		{
+			mpfr_mul(term.ptr(), at(x, j), at(y, k - j), N);
+			if (weighted)
+				mpfr_mul_ui(term.ptr(), term.ptr(), j, N);
+			mpfr_add(sum.ptr(), sum.ptr(), term.ptr(), N);
+		}
+	};
+	int self = &node - nodes.data();
+
+	switch (node.kind)
+	{
+	case Time:
+		if (k == 0)
+			mpfr_set(u, node.value.ptr(), N);
+		else
+			mpfr_set_ui(u, k == 1, N);
+		break;
+	case State:
+		break;
+	case Constant:
+		if (k == 0)
+			mpfr_set(u, node.value.ptr(), N);
+		else
+			mpfr_set_zero(u, 1);
+		break;
+	case Neg:
+		mpfr_neg(u, at(node.a, k), N);
+		break;
+	case Add:
+		mpfr_add(u, at(node.a, k), at(node.b, k), N);
+		break;
+	case Sub:
+		mpfr_sub(u, at(node.a, k), at(node.b, k), N);
+		break;
+	case Mul:
+		convolve(node.a, node.b, 0, k, false);
+		mpfr_set(u, sum.ptr(), N);
+		break;
+	case Div:
+		// q_k = (a_k - sum_{j<k} q_j b_{k-j}) / b_0
+		convolve(self, node.b, 0, k - 1, false);
+		mpfr_sub(u, at(node.a, k), sum.ptr(), N);
+		mpfr_div(u, u, at(node.b, 0), N);
+		break;
+	case Exp:
+		if (k == 0)
+			mpfr_exp(u, at(node.a, 0), N);
+		else
+		{
+			convolve(node.a, self, 1, k, true);
+			mpfr_div_ui(u, sum.ptr(), k, N);
+		}
+		break;
+	case Log:
+		if (k == 0)
+			mpfr_log(u, at(node.a, 0), N);
+		else
+		{
+			convolve(self, node.a, 1, k - 1, true);
+			mpfr_div_ui(sum.ptr(), sum.ptr(), k, N);
+			mpfr_sub(u, at(node.a, k), sum.ptr(), N);
+			mpfr_div(u, u, at(node.a, 0), N);
+		}
+		break;
+	case Sin:
+	case Cos:
+	case Sinh:
+	case Cosh:
+		if (k == 0)
+		{
+			unary_t f[] = {mpfr_sin, mpfr_cos, mpfr_sinh, mpfr_cosh};
+			f[node.kind - Sin](u, at(node.a, 0), N);
+		}
+		else
+		{
+			// s' = a' c, c' = -a' s, hyperbolic without the sign
+			convolve(node.a, node.b, 1, k, true);
+			mpfr_div_ui(u, sum.ptr(), k, N);
+			if (node.kind == Cos)
+				mpfr_neg(u, u, N);
+		}
+		break;
+	case Sqrt:
+		if (k == 0)
+			mpfr_sqrt(u, at(node.a, 0), N);
+		else
+		{
+			convolve(self, self, 1, k - 1, false);
+			mpfr_sub(u, at(node.a, k), sum.ptr(), N);
+			mpfr_div(u, u, at(self, 0), N);
+			mpfr_div_2ui(u, u, 1, N);
+		}
+		break;
+	case Power:
+		if (k == 0)
+			mpfr_pow(u, at(node.a, 0), node.value.ptr(), N);
+		else
+		{
+			// u_k = sum_{j<k} (r (k - j) - j) a_{k-j} u_j / (k a_0)
+			mpfr_set_zero(sum.ptr(), 1);
+			for (int j = 0; j < k; j++)
+			{
+				mpfr_mul_ui(term.ptr(), node.value.ptr(), k - j, N);
+				mpfr_sub_ui(term.ptr(), term.ptr(), j, N);
+				mpfr_mul(term.ptr(), term.ptr(), at(node.a, k - j), N);
+				mpfr_mul(term.ptr(), term.ptr(), at(self, j), N);
+				mpfr_add(sum.ptr(), sum.ptr(), term.ptr(), N);
+			}
+			mpfr_div_ui(u, sum.ptr(), k, N);
+			mpfr_div(u, u, at(node.a, 0), N);
+		}
+		break;
+	case Integral:
+		if (k == 0 && node.start2)
+			node.start2(u, at(node.a, 0), at(node.c, 0), N);
+		else if (k == 0)
+			node.start(u, at(node.a, 0), N);
+		else
+		{
+			convolve(node.a, node.b, 1, k, true);
+			mpfr_set(u, sum.ptr(), N);
+			if (node.c >= 0)
+			{
+				convolve(node.c, node.d, 1, k, true);
+				mpfr_add(u, u, sum.ptr(), N);
+			}
+			mpfr_div_ui(u, u, k, N);
+		}
+		break;
+	case Abs:
+		if (mpfr_sgn(at(node.a, 0)) < 0)
+			mpfr_neg(u, at(node.a, k), N);
+		else
+			mpfr_set(u, at(node.a, k), N);
+		break;
+	case Step:
+		if (k == 0)
+			node.start(u, at(node.a, 0), N);
+		else
+			mpfr_set_zero(u, 1);
+		break;
+	case Min:
+	case Max:
+	{
+		bool first = mpfr_lessequal_p(at(node.a, 0), at(node.b, 0)) == (node.kind == Min);
+		mpfr_set(u, at(first ? node.a : node.b, k), N);
+		break;
+	}
+	}
+}
+
+void TaylorIntegrator::expand(mpfr_srcptr t, const std::vector<Float> &y, int K, Segment &segment)
+{
+	Float sum(working), term(working);
+	for (Node &node : nodes)
+		while ((int)node.series.size() <= K)
+			node.series.emplace_back(working);
+	mpfr_set(nodes[0].value.ptr(), t, N);
+	for (int k = 0; k <= K; k++)
+	{
+		// y_k = f_{k-1} / k
+		for (size_t i = 0; i < components; i++)
+		{
+			mpfr_ptr yk = nodes[i + 1].series[k].ptr();
+			if (k == 0)
+				mpfr_set(yk, y[i].ptr(), N);
+			else
+				mpfr_div_ui(yk, nodes[outputs[i]].series[k - 1].ptr(), k, N);
+		}
+		if (k == K)
+			break;
+		for (Node &node : nodes)
+			coefficient(node, k, sum, term);
+	}
+	segment.coefficients.clear();
+	for (size_t i = 0; i < components; i++)
+		for (int k = 0; k <= K; k++)
+			segment.coefficients.emplace_back(nodes[i + 1].series[k]);
+}
+
+// sum c_k h^k by Horner
+static void horner(mpfr_ptr out, const Float *c, int K, mpfr_srcptr h)
+{
+	mpfr_set(out, c[K].ptr(), N);
+	for (int k = K - 1; k >= 0; k--)
+	{
+		mpfr_mul(out, out, h, N);
+		mpfr_add(out, out, c[k].ptr(), N);
+	}
+}
+
+// log2 |x|, -inf for 0
+static double log2abs(mpfr_srcptr x)
+{
+	if (mpfr_zero_p(x))
+		return -std::numeric_limits<double>::infinity();
+	long e;
+	double d = mpfr_get_d_2exp(&e, x, N);
+	return std::log2(std::fabs(d)) + e;
+}
+
+bool TaylorIntegrator::integrate(mpfr_srcptr t0, mpfr_srcptr const *y0, mpfr_srcptr t1, mpfr_ptr const *y1)
+{
+	Trace::Span span("TaylorIntegrator.integrate", precision);
+	segments.clear();
+	steps = 0;
+	if (!error.empty())
+		return false;
+	int K = effectiveOrder();
+	int direction = mpfr_cmp(t1, t0) < 0 ? -1 : 1;
+	std::vector<Float> y;
+	for (size_t i = 0; i < components; i++)
+	{
+		y.emplace_back(working);
+		mpfr_set(y.back().ptr(), y0[i], N);
+	}
+	Float t(working), h(working), remaining(working);
+	mpfr_set(t.ptr(), t0, N);
+	mpfr_set(start.ptr(), t0, N);
+	mpfr_set(end.ptr(), t0, N);
+	Segment segment{Float(working), Float(working), {}};
+
+	for (; !mpfr_equal_p(t.ptr(), t1); steps++)
+	{
+		if (steps == maxSteps)
+		{
+			std::cerr << "error: no convergence after " << maxSteps << " steps" << std::endl;
+			return false;
+		}
+		expand(t.ptr(), y, K, segment);
+
+		// the last two terms below 2^-precision relative to the state
+		double scale = 0, logh = std::numeric_limits<double>::infinity();
+		for (size_t i = 0; i < components; i++)
+			scale = std::max(scale, log2abs(y[i].ptr()));
+		for (int j = K - 1; j <= K; j++)
+		{
+			double norm = -std::numeric_limits<double>::infinity();
+			for (size_t i = 0; i < components; i++)
+				norm = std::max(norm, log2abs(segment.coefficients[i * (K + 1) + j].ptr()));
+			if (std::isfinite(norm))
+				logh = std::min(logh, (scale - (double)precision - norm) / j);
+		}
+		mpfr_sub(remaining.ptr(), t1, t.ptr(), N);
+		bool last = !std::isfinite(logh) || logh >= log2abs(remaining.ptr());
+		if (last)
+			mpfr_set(h.ptr(), remaining.ptr(), N);
+		else
+		{
+			mpfr_set_d(h.ptr(), std::exp2(logh - std::floor(logh)), N);
+			mpfr_mul_2si(h.ptr(), h.ptr(), std::floor(logh), N);
+			mpfr_mul_si(h.ptr(), h.ptr(), direction, N);
+		}
+		if (std::isnan(logh) || mpfr_zero_p(h.ptr()))
+		{
+			std::cerr << "error: step size vanished at t = " << mpfr_get_d(t.ptr(), N) << std::endl;
+			return false;
+		}
+
+		for (size_t i = 0; i < components; i++)
+		{
+			horner(y[i].ptr(), &segment.coefficients[i * (K + 1)], K, h.ptr());
+			if (!mpfr_number_p(y[i].ptr()))
+			{
+				std::cerr << "error: solution is not finite after t = " << mpfr_get_d(t.ptr(), N) << std::endl;
+				return false;
+			}
+		}
+		if (dense)
+		{
+			mpfr_set(segment.t.ptr(), t.ptr(), N);
+			mpfr_set(segment.h.ptr(), h.ptr(), N);
+			segments.push_back(segment);
+		}
+		if (last)
+			mpfr_set(t.ptr(), t1, N);
+		else
+			mpfr_add(t.ptr(), t.ptr(), h.ptr(), N);
+		mpfr_set(end.ptr(), t.ptr(), N);
+	}
+	for (size_t i = 0; i < components; i++)
+		mpfr_set(y1[i], y[i].ptr(), N);
+	return true;
+}
+
+bool TaylorIntegrator::stateAt(mpfr_srcptr t, mpfr_ptr const *y)
+{
+	bool forward = mpfr_lessequal_p(start.ptr(), end.ptr());
+	mpfr_srcptr lo = forward ? start.ptr() : end.ptr(), hi = forward ? end.ptr() : start.ptr();
+	if (segments.empty() || mpfr_less_p(t, lo) || mpfr_greater_p(t, hi))
+	{
+		std::cerr << "error: no dense output at t = " << mpfr_get_d(t, N) << std::endl;
+		return false;
+	}
+	// last segment starting at or before t, in the direction of integration
+	auto it = std::upper_bound(segments.begin(), segments.end(), t, [&](mpfr_srcptr x, const Segment &s) {
+		return forward ? mpfr_less_p(x, s.t.ptr()) : mpfr_greater_p(x, s.t.ptr());
+	});
+	const Segment &segment = *(it == segments.begin() ? it : it - 1);
+	int K = segment.coefficients.size() / components - 1;
+	Float tau(working), x(working);
+	mpfr_sub(tau.ptr(), t, segment.t.ptr(), N);
+	for (size_t i = 0; i < components; i++)
+	{
+		horner(x.ptr(), &segment.coefficients[i * (K + 1)], K, tau.ptr());
+		mpfr_set(y[i], x.ptr(), N);
+	}
+	return true;
+}
+
+// JS side
+
+Float TaylorIntegrator::read(val v) const
+{
+	Float x(working);
+	x.set(v);
+	return x;
+}
+
+FloatArray TaylorIntegrator::integrate(val t0, val y0, val t1)
+{
+	FloatArray out(components, precision);
+	std::vector<Float> holder;
+	std::vector<mpfr_srcptr> initial = Formula::arguments(y0, holder);
+	if (initial.size() != components)
+	{
+		std::cerr << "error: expected " << components << " initial values, got " << initial.size() << std::endl;
+		return out;
+	}
+	std::vector<mpfr_ptr> results(components);
+	for (size_t i = 0; i < components; i++)
+		results[i] = out.at(i);
+	Float a = read(t0), b = read(t1);
+	integrate(a.ptr(), initial.data(), b.ptr(), results.data());
+	return out;
+}
+
+FloatArray TaylorIntegrator::stateAt(val t)
+{
+	FloatArray out(components, precision);
+	std::vector<mpfr_ptr> results(components);
+	for (size_t i = 0; i < components; i++)
+		results[i] = out.at(i);
+	stateAt(read(t).ptr(), results.data());
+	return out;
+}
+
+Float TaylorIntegrator::valueAt(val t, size_t component)
+{
+	Float out(precision);
+	if (component >= components)
+	{
+		std::cerr << "error: component " << component << " out of range" << std::endl;
+		return out;
+	}
+	FloatArray state = stateAt(t);
+	mpfr_set(out.ptr(), state.at(component), N);
+	return out;
+}
@@ -0,0 +1,59 @@
+#include <mpfr.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <emscripten.h>
+
+#include "Trace.hpp"
+
+bool Trace::enabled = false;
+
+static std::vector<Trace::Event> events;
+static size_t next = 0, count = 0, dropped = 0;
+static int thread = 1;
+
+void Trace::start(size_t capacity)
+{
+	events.assign(capacity, Event{nullptr, 0, 0, 0});
+	next = count = dropped = 0;
+	enabled = capacity > 0;
+}
+
+void Trace::stop() { enabled = false; }
+
+void Trace::clear() { next = count = dropped = 0; }
+
+bool Trace::isEnabled() { return enabled; }
+size_t Trace::getCount() { return count; }
+size_t Trace::getDropped() { return dropped; }
+int Trace::getThread() { return thread; }
+void Trace::setThread(int tid) { thread = tid; }
+
+void Trace::record(const char *name, prec_t precision, double begin, double end)
+{
+	if (events.empty())
+		return;
+	events[next] = Event{name, begin, end - begin, precision};
+	next = (next + 1) % events.size();
+	if (count < events.size())
+		count++;
+	else
+		dropped++;
+}
+
+// complete ("X") events, emscripten_get_now is in milliseconds
+std::string Trace::toJSON()
+{
+	std::string out = "{\"traceEvents\":[";
+	char buffer[256];
+	size_t first = count < events.size() ? 0 : next;
+	for (size_t i = 0; i < count; i++)
+	{
+		const Event &e = events[(first + i) % events.size()];
+		std::snprintf(buffer, sizeof(buffer), "%s{\"name\":\"%s\",\"cat\":\"gnu-mp\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d,\"args\":{\"precision\":%ld}}",
+					  i ? "," : "", e.name, e.begin * 1000, e.duration * 1000, thread, (long)e.precision);
+		out += buffer;
+	}
+	out += "],\"displayTimeUnit\":\"ns\"}";
+	return out;
+}
@@ -1,7 +1,61 @@
 #include "Float.hpp"
+#include "DigitStream.hpp"
+#include "LazyFloat.hpp"
+#include "Accumulator.hpp"
+#include "FloatArray.hpp"
+#include "Formula.hpp"
+#include "Quadrature.hpp"
+#include "RootFinder.hpp"
+#include "Series.hpp"
+#include "Context.hpp"
+#include "Constants.hpp"
+#include "FloatTable.hpp"
+#include "PrecisionAnalyzer.hpp"
+#include "Memory.hpp"
+#include "Checkpoint.hpp"
+#include "Dual.hpp"
+#include "TaylorIntegrator.hpp"
+#include "Trace.hpp"
+#include "Statistics.hpp"
+#include "IntegerRelation.hpp"
+#include "Convolution.hpp"
 #include "utils.hpp"
 #include <emscripten/bind.h>
 
+// the entry points that create Floats check the memory budget before any
+// native state exists, the RangeError cannot skip a destructor there
+
+static Float *newFloat(val v)
+{
+	if (v.isNumber())
+		Memory::check(v.as<size_t>());
+	return new Float(v);
+}
+
+static void setFloatPrecision(Float &x, Float::size_t precision)
+{
+	Memory::check(precision);
+	x.setPrecision(precision);
+}
+
+static FloatArray *newFloatArray(size_t length, FloatArray::prec_t precision)
+{
+	Memory::check(precision, length);
+	return new FloatArray(length, precision);
+}
+
+static FloatArray floatArrayFrom(val array, FloatArray::prec_t precision)
+{
+	Memory::check(precision, array["length"].as<size_t>());
+	return FloatArray::from(array, precision);
+}
+
+static FloatArray floatArrayFromDoubleDouble(val pairs, FloatArray::prec_t precision)
+{
+	Memory::check(precision, pairs["length"].as<size_t>() / 2);
+	return FloatArray::fromDoubleDouble(pairs, precision);
+}
+
 EMSCRIPTEN_BINDINGS(my_module)
 {
 	constant("Nearest", (int)mpfr_rnd_t::MPFR_RNDN);
@@ -13,19 +67,21 @@ EMSCRIPTEN_BINDINGS(my_module)
 
 	class_<Float>("Float")
 		.constructor()
-		.constructor<val>()
+		.constructor(&newFloat, allow_raw_pointers())
 		// properties
 		.property("rounding", &Float::getRounding, &Float::setRounding)
-		.property("precision", &Float::getPrecision, &Float::setPrecision)
+		.property("precision", &Float::getPrecision, &setFloatPrecision)
 		.property("exponent", &Float::getExponent, &Float::setExponent)
 		.property("sign", &Float::getSign, &Float::setSign)
 
 		// assignments
 		.function("set", &Float::set)
 		.function("set", select_overload<Float::builder_pattern(const std::string &, int)>(&Float::setString))
+		.function("setBigInt", select_overload<Float::builder_pattern(val)>(&Float::setBigInt))
+		.function("setBigInt", select_overload<Float::builder_pattern(val, Float::exp_t)>(&Float::setBigInt))
 		.function("swap", &Float::swap)
 		.function("setRounding", &Float::setRounding)
-		.function("setPrecision", &Float::setPrecision)
+		.function("setPrecision", &setFloatPrecision)
 		.function("setExponent", &Float::setExponent)
 		.function("setSign", &Float::setSign)
 
@@ -35,6 +91,13 @@ EMSCRIPTEN_BINDINGS(my_module)
 		.function("toString", select_overload<std::string(int, int)>(&Float::toString))
 		.function("toNumber", &Float::toNumber)
 		.function("valueOf", &Float::toNumber)
+		.function("toBinary", &Float::toBinary)
+		.function("hash", select_overload<uint32_t() const>(&Float::hash))
+		.class_function("fromBinary", &Float::fromBinary)
+		.function("toBigInt", select_overload<val()>(&Float::toBigInt))
+		.function("toBigInt", select_overload<val(Float::exp_t)>(&Float::toBigInt))
+		.class_function("fromBigInt", select_overload<Float(val, Float::prec_t)>(&Float::fromBigInt))
+		.class_function("fromBigInt", select_overload<Float(val, Float::prec_t, Float::exp_t)>(&Float::fromBigInt))
 
 		// comparisons
 		.function("less", &Float::less)
@@ -143,8 +206,10 @@ EMSCRIPTEN_BINDINGS(my_module)
 		.class_function("fms", &Float::op_fms)
 		.class_function("fmms", &Float::op_fmms)
 		.class_function("hypot", &Float::op_hypot)
-		.class_function("sum", &Float::op_sum)
-		.class_function("dot", &Float::op_dot)
+		.class_function("sum", select_overload<int(Float &, val)>(&Float::op_sum))
+		.class_function("sum", select_overload<int(Float &, val, Context &)>(&Float::op_sum))
+		.class_function("dot", select_overload<int(Float &, val, val)>(&Float::op_dot))
+		.class_function("dot", select_overload<int(Float &, val, val, Context &)>(&Float::op_dot))
 
 		// TRANSCENDENTALS
 
@@ -300,4 +365,348 @@ EMSCRIPTEN_BINDINGS(my_module)
 		.class_function("flags_set", Float::op_flags_set)
 		.class_function("flags_test", Float::op_flags_test)
 		.class_function("flags_restore", Float::op_flags_restore);
-};
\ No newline at end of file
+
+	class_<DigitStream>("DigitStream")
+		.constructor<const Float &, int, int, size_t>()
+		.property("exponent", &DigitStream::getExponent)
+		.property("digits", &DigitStream::getDigits)
+		.function("done", &DigitStream::done)
+		.function("next", &DigitStream::next);
+
+	class_<LazyFloat>("LazyFloat")
+		.constructor<val>()
+		.property("rounding", &LazyFloat::getRounding, &LazyFloat::setRounding)
+		.property("precision", &LazyFloat::getPrecision, &LazyFloat::setPrecision)
+		.property("pending", &LazyFloat::isPending)
+		.function("setRounding", &LazyFloat::setRounding)
+		.function("setPrecision", &LazyFloat::setPrecision)
+		.function("set", &LazyFloat::set)
+
+		// observation
+		.function("toFloat", &LazyFloat::toFloat)
+		.function("toString", select_overload<std::string()>(&LazyFloat::toString))
+		.function("toString", select_overload<std::string(int)>(&LazyFloat::toString))
+		.function("toString", select_overload<std::string(int, int)>(&LazyFloat::toString))
+		.function("toNumber", &LazyFloat::toNumber)
+		.function("valueOf", &LazyFloat::toNumber)
+		.function("less", &LazyFloat::less)
+		.function("less_equal", &LazyFloat::less_equal)
+		.function("greater", &LazyFloat::greater)
+		.function("greater_equal", &LazyFloat::greater_equal)
+		.function("equal", &LazyFloat::equal)
+		.function("not_equal", &LazyFloat::not_equal)
+
+		// recorded operations
+		.function("add", &LazyFloat::add)
+		.function("sub", &LazyFloat::sub)
+		.function("mul", &LazyFloat::mul)
+		.function("div", &LazyFloat::div)
+		.function("fma", &LazyFloat::fma)
+		.function("fms", &LazyFloat::fms)
+		.function("fmma", &LazyFloat::fmma)
+		.function("fmms", &LazyFloat::fmms)
+		.function("sqr", &LazyFloat::sqr)
+		.function("sqrt", &LazyFloat::sqrt)
+		.function("rec_sqrt", &LazyFloat::rec_sqrt)
+		.function("cbrt", &LazyFloat::cbrt)
+		.function("neg", &LazyFloat::neg)
+		.function("abs", &LazyFloat::abs)
+		.function("log", &LazyFloat::log)
+		.function("log2", &LazyFloat::log2)
+		.function("log10", &LazyFloat::log10)
+		.function("log1p", &LazyFloat::log1p)
+		.function("exp", &LazyFloat::exp)
+		.function("exp2", &LazyFloat::exp2)
+		.function("exp10", &LazyFloat::exp10)
+		.function("expm1", &LazyFloat::expm1)
+		.function("cos", &LazyFloat::cos)
+		.function("sin", &LazyFloat::sin)
+		.function("tan", &LazyFloat::tan)
+		.function("sec", &LazyFloat::sec)
+		.function("csc", &LazyFloat::csc)
+		.function("cot", &LazyFloat::cot)
+		.function("acos", &LazyFloat::acos)
+		.function("asin", &LazyFloat::asin)
+		.function("atan", &LazyFloat::atan)
+		.function("cosh", &LazyFloat::cosh)
+		.function("sinh", &LazyFloat::sinh)
+		.function("tanh", &LazyFloat::tanh)
+		.function("sech", &LazyFloat::sech)
+		.function("csch", &LazyFloat::csch)
+		.function("coth", &LazyFloat::coth)
+		.function("acosh", &LazyFloat::acosh)
+		.function("asinh", &LazyFloat::asinh)
+		.function("atanh", &LazyFloat::atanh)
+		.function("eint", &LazyFloat::eint)
+		.function("li2", &LazyFloat::li2)
+		.function("gamma", &LazyFloat::gamma)
+		.function("lngamma", &LazyFloat::lngamma)
+		.function("digamma", &LazyFloat::digamma)
+		.function("zeta", &LazyFloat::zeta)
+		.function("erf", &LazyFloat::erf)
+		.function("erfc", &LazyFloat::erfc)
+		.function("j0", &LazyFloat::j0)
+		.function("j1", &LazyFloat::j1)
+		.function("y0", &LazyFloat::y0)
+		.function("y1", &LazyFloat::y1)
+		.function("ai", &LazyFloat::ai);
+
+	class_<Accumulator>("Accumulator")
+		.constructor<Accumulator::prec_t>()
+		.property("precision", &Accumulator::getPrecision, &Accumulator::setPrecision)
+		.function("reset", &Accumulator::reset)
+		.function("add", &Accumulator::add)
+		.function("sub", &Accumulator::sub)
+		.function("addAll", &Accumulator::addAll)
+		.function("addDot", &Accumulator::addDot)
+		.function("result", &Accumulator::result);
+
+	class_<FloatArray>("FloatArray")
+		.constructor(&newFloatArray, allow_raw_pointers())
+		.class_function("from", &floatArrayFrom)
+		.class_function("fromDoubleDouble", &floatArrayFromDoubleDouble)
+		.property("length", &FloatArray::getLength)
+		.property("rounding", &FloatArray::getRounding, &FloatArray::setRounding)
+		.function("get", &FloatArray::get)
+		.function("set", &FloatArray::set)
+		.function("sort", &FloatArray::sort)
+		.function("stableSort", &FloatArray::stableSort)
+		.function("argsort", &FloatArray::argsort)
+		.function("lowerBound", &FloatArray::lowerBound)
+		.function("upperBound", &FloatArray::upperBound)
+		.function("argmin", &FloatArray::argmin)
+		.function("argmax", &FloatArray::argmax)
+		.function("min", &FloatArray::min)
+		.function("max", &FloatArray::max)
+		.function("select", &FloatArray::select)
+		.function("toFloat64Array", select_overload<val() const>(&FloatArray::toFloat64Array))
+		.function("toFloat64Array", select_overload<val(val) const>(&FloatArray::toFloat64Array))
+		.function("toDoubleDouble", select_overload<val() const>(&FloatArray::toDoubleDouble))
+		.function("toDoubleDouble", select_overload<val(val) const>(&FloatArray::toDoubleDouble));
+
+	class_<Formula>("Formula")
+		.constructor<const std::string &, val>()
+		.property("valid", &Formula::isValid)
+		.property("error", &Formula::getError)
+		.property("variableCount", &Formula::getVariableCount)
+		.function("evaluate", select_overload<int(Float &, val)>(&Formula::evaluate))
+		.function("evaluateBatch", select_overload<Formula::builder_pattern(val, FloatArray &)>(&Formula::evaluateBatch))
+		.function("evaluateBatch", select_overload<Formula::builder_pattern(val, FloatArray &, Context &)>(&Formula::evaluateBatch));
+
+	constant("GaussLegendre", (int)Quadrature::GaussLegendre);
+	constant("TanhSinh", (int)Quadrature::TanhSinh);
+
+	class_<Quadrature>("Quadrature")
+		.constructor<int, Quadrature::prec_t>()
+		.class_function("cacheSize", &Quadrature::cacheSize)
+		.class_function("clearCache", &Quadrature::clearCache)
+		.property("precision", &Quadrature::getPrecision, &Quadrature::setPrecision)
+		.property("maxLevel", &Quadrature::getMaxLevel, &Quadrature::setMaxLevel)
+		.property("levels", &Quadrature::getLevels)
+		.property("error", &Quadrature::getError)
+		.function("integrate", select_overload<Float(val, val, val)>(&Quadrature::integrate))
+		.function("integrate", select_overload<Float(val, val, val, Context &)>(&Quadrature::integrate));
+
+	class_<RootFinder>("RootFinder")
+		.constructor<RootFinder::prec_t>()
+		.property("precision", &RootFinder::getPrecision, &RootFinder::setPrecision)
+		.property("rounding", &RootFinder::getRounding, &RootFinder::setRounding)
+		.property("maxIterations", &RootFinder::getMaxIterations, &RootFinder::setMaxIterations)
+		.property("iterations", &RootFinder::getIterations)
+		.property("converged", &RootFinder::isConverged)
+		.function("solve", &RootFinder::solve)
+		.function("polynomial", &RootFinder::polynomial);
+
+	class_<SeriesRange>("SeriesRange")
+		.property("begin", &SeriesRange::getBegin)
+		.property("end", &SeriesRange::getEnd)
+		.function("serialize", &SeriesRange::serialize)
+		.class_function("deserialize", &SeriesRange::deserialize);
+
+	class_<Series>("Series")
+		.constructor<val, val, val>()
+		.function("terms", &Series::terms)
+		.function("range", &Series::range)
+		.function("evaluate", &Series::evaluate)
+		.class_function("combine", &Series::combine)
+		.class_function("value", &Series::value);
+
+	class_<Context>("Context")
+		.constructor()
+		.property("rounding", &Context::getRounding, &Context::setRounding)
+		.property("emin", &Context::getEmin, &Context::setEmin)
+		.property("emax", &Context::getEmax, &Context::setEmax)
+		.property("flags", &Context::getFlags)
+		.function("clearFlags", &Context::clearFlags)
+		.function("testFlags", &Context::testFlags)
+		.function("enter", &Context::enter)
+		.function("exit", &Context::exit);
+
+	class_<Constants>("Constants")
+		.class_function("get", &Constants::get)
+		.class_function("put", &Constants::put)
+		.class_function("precision", &Constants::precision)
+		.class_function("names", &Constants::names)
+		.class_function("clear", &Constants::clear)
+		.class_function("save", &Constants::save)
+		.class_function("load", &Constants::load);
+
+	class_<FloatSet>("FloatSet")
+		.constructor()
+		.property("size", &FloatSet::getSize)
+		.function("add", &FloatSet::add)
+		.function("addAll", &FloatSet::addAll)
+		.function("has", &FloatSet::has)
+		.function("delete", &FloatSet::remove)
+		.function("clear", &FloatSet::clear)
+		.function("values", &FloatSet::values);
+
+	class_<FloatMap>("FloatMap")
+		.constructor()
+		.property("size", &FloatMap::getSize)
+		.function("set", &FloatMap::set)
+		.function("get", &FloatMap::get)
+		.function("has", &FloatMap::has)
+		.function("delete", &FloatMap::remove)
+		.function("clear", &FloatMap::clear)
+		.function("keys", &FloatMap::keys)
+		.function("entries", &FloatMap::entries);
+
+	class_<PrecisionAnalyzer>("PrecisionAnalyzer")
+		.constructor<const Formula &>()
+		.property("guard", &PrecisionAnalyzer::getGuard, &PrecisionAnalyzer::setGuard)
+		.function("analyze", select_overload<val(val, int)>(&PrecisionAnalyzer::analyze));
+
+	class_<Memory>("Memory")
+		.class_function("getBudget", &Memory::getBudget)
+		.class_function("setBudget", &Memory::setBudget)
+		.class_function("getTrimRatio", &Memory::getTrimRatio)
+		.class_function("setTrimRatio", &Memory::setTrimRatio)
+		.class_function("getUsed", &Memory::getUsed)
+		.class_function("getPeak", &Memory::getPeak)
+		.class_function("resetPeak", &Memory::resetPeak)
+		.class_function("trim", &Memory::trim);
+
+	class_<Checkpoint>("Checkpoint")
+		.constructor()
+		.property("state", &Checkpoint::getState, &Checkpoint::setState)
+		.property("generation", &Checkpoint::getGeneration)
+		.property("pendingSize", &Checkpoint::getPendingSize)
+		.property("loadedSize", &Checkpoint::getLoadedSize)
+		.function("set", &Checkpoint::set)
+		.function("get", &Checkpoint::get)
+		.function("has", &Checkpoint::has)
+		.function("delete", &Checkpoint::remove)
+		.function("names", &Checkpoint::names)
+		.function("save", &Checkpoint::save)
+		.function("load", &Checkpoint::load);
+
+	class_<Dual>("Dual")
+		.constructor<size_t, Dual::prec_t>()
+		.property("directions", &Dual::getDirections)
+		.property("precision", &Dual::getPrecision)
+		.property("rounding", &Dual::getRounding, &Dual::setRounding)
+		.property("value", &Dual::getValue)
+		.function("seed", &Dual::seed)
+		.function("set", &Dual::set)
+		.function("setValue", &Dual::setValue)
+		.function("setDerivative", &Dual::setDerivative)
+		.function("derivative", &Dual::getDerivative)
+		.function("gradient", &Dual::gradient)
+		.function("add", &Dual::add)
+		.function("sub", &Dual::sub)
+		.function("mul", &Dual::mul)
+		.function("div", &Dual::div)
+		.function("pow", &Dual::pow)
+		.function("pow_si", &Dual::pow_si)
+		.function("neg", &Dual::neg)
+		.function("abs", &Dual::abs)
+		.function("sqr", &Dual::sqr)
+		.function("sqrt", &Dual::sqrt)
+		.function("cbrt", &Dual::cbrt)
+		.function("exp", &Dual::exp)
+		.function("exp2", &Dual::exp2)
+		.function("exp10", &Dual::exp10)
+		.function("expm1", &Dual::expm1)
+		.function("log", &Dual::log)
+		.function("log2", &Dual::log2)
+		.function("log10", &Dual::log10)
+		.function("log1p", &Dual::log1p)
+		.function("sin", &Dual::sin)
+		.function("cos", &Dual::cos)
+		.function("tan", &Dual::tan)
+		.function("asin", &Dual::asin)
+		.function("acos", &Dual::acos)
+		.function("atan", &Dual::atan)
+		.function("sinh", &Dual::sinh)
+		.function("cosh", &Dual::cosh)
+		.function("tanh", &Dual::tanh)
+		.function("asinh", &Dual::asinh)
+		.function("acosh", &Dual::acosh)
+		.function("atanh", &Dual::atanh)
+		.function("gamma", &Dual::gamma)
+		.function("lngamma", &Dual::lngamma)
+		.function("eint", &Dual::eint)
+		.function("li2", &Dual::li2)
+		.function("erf", &Dual::erf)
+		.function("erfc", &Dual::erfc)
+		.function("j0", &Dual::j0)
+		.function("j1", &Dual::j1)
+		.function("y0", &Dual::y0)
+		.function("y1", &Dual::y1);
+
+	class_<TaylorIntegrator>("TaylorIntegrator")
+		.constructor<val, TaylorIntegrator::prec_t>()
+		.property("valid", &TaylorIntegrator::isValid)
+		.property("error", &TaylorIntegrator::getError)
+		.property("precision", &TaylorIntegrator::getPrecision)
+		.property("order", &TaylorIntegrator::getOrder, &TaylorIntegrator::setOrder)
+		.property("maxSteps", &TaylorIntegrator::getMaxSteps, &TaylorIntegrator::setMaxSteps)
+		.property("denseOutput", &TaylorIntegrator::getDenseOutput, &TaylorIntegrator::setDenseOutput)
+		.property("steps", &TaylorIntegrator::getSteps)
+		.function("integrate", select_overload<FloatArray(val, val, val)>(&TaylorIntegrator::integrate))
+		.function("stateAt", select_overload<FloatArray(val)>(&TaylorIntegrator::stateAt))
+		.function("valueAt", &TaylorIntegrator::valueAt);
+
+	class_<Trace>("Trace")
+		.class_function("start", &Trace::start)
+		.class_function("stop", &Trace::stop)
+		.class_function("clear", &Trace::clear)
+		.class_function("isEnabled", &Trace::isEnabled)
+		.class_function("getCount", &Trace::getCount)
+		.class_function("getDropped", &Trace::getDropped)
+		.class_function("getThread", &Trace::getThread)
+		.class_function("setThread", &Trace::setThread)
+		.class_function("toJSON", &Trace::toJSON);
+
+	class_<Statistics>("Statistics")
+		.constructor<Statistics::prec_t>()
+		.property("precision", &Statistics::getPrecision, &Statistics::setPrecision)
+		.property("rounding", &Statistics::getRounding, &Statistics::setRounding)
+		.function("mean", &Statistics::mean)
+		.function("variance", &Statistics::variance)
+		.function("covariance", &Statistics::covariance)
+		.function("moment", &Statistics::moment)
+		.function("weightedMean", &Statistics::weightedMean)
+		.function("weightedVariance", &Statistics::weightedVariance)
+		.function("weightedCovariance", &Statistics::weightedCovariance);
+
+	class_<IntegerRelation>("IntegerRelation")
+		.constructor<IntegerRelation::prec_t>()
+		.property("precision", &IntegerRelation::getPrecision, &IntegerRelation::setPrecision)
+		.property("maxIterations", &IntegerRelation::getMaxIterations, &IntegerRelation::setMaxIterations)
+		.property("iterations", &IntegerRelation::getIterations)
+		.property("found", &IntegerRelation::isFound)
+		.property("bound", &IntegerRelation::getBound)
+		.property("residual", &IntegerRelation::getResidual)
+		.function("pslq", &IntegerRelation::pslq)
+		.function("lll", &IntegerRelation::lll);
+
+	class_<Convolution>("Convolution")
+		.constructor<Convolution::prec_t>()
+		.property("precision", &Convolution::getPrecision, &Convolution::setPrecision)
+		.property("rounding", &Convolution::getRounding, &Convolution::setRounding)
+		.property("method", &Convolution::getMethod, &Convolution::setMethod)
+		.property("used", &Convolution::getUsed)
+		.function("convolve", select_overload<FloatArray(val, val)>(&Convolution::convolve));
+};
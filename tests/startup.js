@@ -0,0 +1,41 @@
+// Startup benchmark, run after make: node tests/startup.js [workers]
+const { Worker } = require('worker_threads');
+const fs = require('fs');
+const path = require('path');
+
+const dist = path.join(__dirname, '../dist/npm');
+const Loader = require(path.join(dist, 'Loader.js'));
+const factory = require(path.join(dist, 'gnu-mp.js'));
+
+async function time(label, fn) {
+	const start = process.hrtime.bigint();
+	const result = await fn();
+	console.log(label.padEnd(36), (Number(process.hrtime.bigint() - start) / 1e6).toFixed(2), 'ms');
+	return result;
+}
+
+// a worker that loads the module, answers once, and exits
+const workerSource = `
+	const { parentPort, workerData } = require('worker_threads');
+	const Loader = require(workerData.dist + '/Loader.js');
+	const options = workerData.wasmModule ? Loader.options(workerData.wasmModule) : {};
+	require(workerData.dist + '/gnu-mp.js')(options).then(() => parentPort.postMessage('ready'));
+`;
+
+function worker(wasmModule) {
+	return new Promise(resolve => {
+		const w = new Worker(workerSource, { eval: true, workerData: { dist, wasmModule } });
+		w.once('message', () => w.terminate().then(resolve));
+	});
+}
+
+(async function () {
+	const workers = +process.argv[2] || 8;
+
+	await time('cold load (fetch, compile, instantiate)', () => factory());
+	const wasmModule = await time('compile only', () => WebAssembly.compile(fs.readFileSync(path.join(dist, 'gnu-mp.wasm'))));
+	await time('warm load (instantiate cached module)', () => factory(Loader.options(wasmModule)));
+
+	await time(workers + ' workers, each compiling', () => Promise.all(Array.from({ length: workers }, () => worker())));
+	await time(workers + ' workers, shared module', () => Promise.all(Array.from({ length: workers }, () => worker(wasmModule))));
+})();